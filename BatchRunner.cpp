@@ -0,0 +1,100 @@
+#include "BatchRunner.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <mutex>
+
+using namespace std;
+
+double BatchStats::winRate() const {
+    return games > 0 ? static_cast<double>(wins) / games : 0.0;
+}
+
+double BatchStats::meanTurns() const {
+    if (turnCounts.empty()) {
+        return 0.0;
+    }
+    long long total = 0;
+    for (int turns : turnCounts) {
+        total += turns;
+    }
+    return static_cast<double>(total) / turnCounts.size();
+}
+
+int BatchStats::turnPercentile(double percentile) const {
+    if (turnCounts.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(percentile / 100.0 * (turnCounts.size() - 1) + 0.5);
+    return turnCounts[min(index, turnCounts.size() - 1)];
+}
+
+BatchRunner::BatchRunner(const Maze& mapTemplate, int threads, uint64_t batchSeed) 
+    : maze(mapTemplate), threadCount(threads), seed(batchSeed), config(batchSeed) {
+}
+
+BatchRunner::BatchRunner(const Maze& mapTemplate, int threads, const GameConfig& gameConfig) 
+    : maze(mapTemplate), threadCount(threads), seed(gameConfig.seed), config(gameConfig) {
+}
+
+uint64_t BatchRunner::gameSeed(uint64_t batchSeed, int index) {
+    return Rng::mix(batchSeed + static_cast<uint64_t>(index));
+}
+
+BatchStats BatchRunner::run(int games) {
+    vector<GameResult> results(games);
+    
+    auto start = chrono::steady_clock::now();
+    
+    // Exceptions can't cross threads, keep the first one and rethrow it here
+    exception_ptr failure;
+    mutex failureMutex;
+    
+    ThreadPool pool(threadCount);
+    threadCount = pool.getThreadCount();
+    pool.parallelFor(games, [&](int index, int worker) {
+        try {
+            GameConfig gameConfig = config;
+            gameConfig.seed = gameSeed(seed, index);
+            Game game(maze, new NullRenderer(), gameConfig);
+            results[index] = game.runToCompletion();
+        } catch (...) {
+            lock_guard<mutex> lock(failureMutex);
+            if (!failure) {
+                failure = current_exception();
+            }
+        }
+    });
+    
+    if (failure) {
+        rethrow_exception(failure);
+    }
+    
+    BatchStats stats;
+    stats.games = games;
+    stats.wins = 0;
+    stats.losses = 0;
+    stats.wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    for (int i = 0; i < GAME_PHASE_COUNT; i++) {
+        stats.phaseTurns[i] = 0;
+        stats.phaseSeconds[i] = 0.0;
+    }
+    
+    stats.turnCounts.reserve(games);
+    for (const auto& result : results) {
+        if (result.won) {
+            stats.wins++;
+        } else {
+            stats.losses++;
+        }
+        stats.turnCounts.push_back(result.turns);
+        for (int i = 0; i < GAME_PHASE_COUNT; i++) {
+            stats.phaseTurns[i] += result.phaseTurns[i];
+            stats.phaseSeconds[i] += result.phaseSeconds[i];
+        }
+    }
+    sort(stats.turnCounts.begin(), stats.turnCounts.end());
+    
+    return stats;
+}
@@ -0,0 +1,49 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <vector>
+#include "Game.h"
+#include "Maze.h"
+
+// Aggregated outcome of many independent games on the same map
+struct BatchStats {
+    int games;
+    int wins;
+    int losses;
+    double wallSeconds;
+    
+    // Sorted turn counts, one per game
+    std::vector<int> turnCounts;
+    
+    // Totals over all games, indexed by GamePhase
+    long long phaseTurns[GAME_PHASE_COUNT];
+    double phaseSeconds[GAME_PHASE_COUNT];
+    
+    double winRate() const;
+    double meanTurns() const;
+    int turnPercentile(double percentile) const;
+};
+
+// Runs headless games on a thread pool. Every game gets its own copy
+// of the maze and its own random generator, so no state is shared.
+// Game i is seeded from the batch seed and i alone, so the results
+// do not depend on the thread count.
+class BatchRunner {
+public:
+    BatchRunner(const Maze& mapTemplate, int threads, uint64_t batchSeed);
+    // Every game uses gameConfig apart from the seed, gameConfig.seed is the batch seed
+    BatchRunner(const Maze& mapTemplate, int threads, const GameConfig& gameConfig);
+    
+    BatchStats run(int games);
+    int getThreadCount() const { return threadCount; }
+    
+    static uint64_t gameSeed(uint64_t batchSeed, int index);
+    
+private:
+    const Maze& maze;
+    int threadCount;
+    uint64_t seed;
+    GameConfig config;
+};
+
+#endif
@@ -0,0 +1,219 @@
+#include "DistanceOracle.h"
+#include "Maze.h"
+#include "MazeFormat.h"
+#include "MappedFile.h"
+#include "MapHashCache.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+const uint16_t DistanceOracle::UNREACHABLE;
+const uint16_t DistanceOracle::MAX_DISTANCE;
+const int DistanceOracle::MAX_LANDMARKS;
+
+shared_ptr<const DistanceOracle> DistanceOracle::get(const Maze& maze, int landmarkCount) {
+    static MapHashCache<DistanceOracle> cache;
+    uint64_t hash = maze.getContentHash();
+    return cache.get(hash, 
+        [&](const DistanceOracle& oracle) {
+            return oracle.width == maze.getWidth() && oracle.height == maze.getHeight() && 
+                   oracle.landmarkCount >= landmarkCount;
+        }, 
+        [&]() {
+            shared_ptr<const DistanceOracle> built = findPrecomputed(maze, hash, landmarkCount);
+            return built ? built : make_shared<const DistanceOracle>(maze, landmarkCount);
+        });
+}
+
+DistanceOracle::DistanceOracle(const Maze& maze, int count) 
+    : width(maze.getWidth()), height(maze.getHeight()), mapHash(maze.getContentHash()), landmarkCount(0),
+      ladderField(nullptr), landmarkFields(nullptr) {
+    
+    if (count < 0 || count > MAX_LANDMARKS) {
+        throw runtime_error("Landmark count must be between 0 and " + to_string(MAX_LANDMARKS));
+    }
+    
+    size_t cells = static_cast<size_t>(width) * height;
+    vector<pair<int, int>> queue;
+    ladderStorage.assign(cells, UNREACHABLE);
+    ladderField = ladderStorage.data();
+    if (maze.isValidPosition(maze.getLadderX(), maze.getLadderY())) {
+        breadthFirst(maze, maze.getLadderX(), maze.getLadderY(), ladderStorage.data(), 1, queue);
+    }
+    if (count == 0) {
+        return;
+    }
+    
+    // Farthest-point selection: every landmark is the open cell farthest
+    // from the ones chosen before, starting from the ladder. Cells nothing
+    // chosen so far reaches count as farthest.
+    vector<uint16_t> nearest(ladderStorage);
+    landmarkStorage.assign(cells * count, UNREACHABLE);
+    for (int i = 0; i < count; i++) {
+        size_t best = cells;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                size_t cell = static_cast<size_t>(y) * width + x;
+                if (!maze.isWallUnchecked(x, y) && (best == cells || nearest[cell] > nearest[best])) {
+                    best = cell;
+                }
+            }
+        }
+        if (best == cells || (i > 0 && nearest[best] == 0)) {
+            break; // Every open cell is a landmark already
+        }
+        
+        landmarks.push_back({static_cast<int>(best % width), static_cast<int>(best / width)});
+        uint16_t* field = landmarkStorage.data() + i;
+        breadthFirst(maze, landmarks.back().first, landmarks.back().second, field, count, queue);
+        for (size_t cell = 0; cell < cells; cell++) {
+            nearest[cell] = min(nearest[cell], field[cell * count]);
+        }
+    }
+    
+    // Tiny maps may have fewer open cells than landmarks asked for
+    landmarkCount = landmarks.size();
+    if (landmarkCount < count) {
+        vector<uint16_t> packed(cells * landmarkCount);
+        for (size_t cell = 0; cell < cells; cell++) {
+            copy_n(&landmarkStorage[cell * count], landmarkCount, &packed[cell * landmarkCount]);
+        }
+        landmarkStorage.swap(packed);
+    }
+    landmarkFields = landmarkStorage.data();
+}
+
+void DistanceOracle::breadthFirst(const Maze& maze, int startX, int startY, uint16_t* field, size_t stride,
+                                  vector<pair<int, int>>& queue) const {
+    static const int DX[4] = {0, 1, 0, -1};
+    static const int DY[4] = {-1, 0, 1, 0};
+    
+    queue.clear();
+    if (maze.isWallUnchecked(startX, startY)) {
+        return;
+    }
+    field[(static_cast<size_t>(startY) * width + startX) * stride] = 0;
+    queue.push_back({startX, startY});
+    
+    // Out of map neighbours are border walls, no bounds checks needed
+    for (size_t head = 0; head < queue.size(); head++) {
+        int x = queue[head].first;
+        int y = queue[head].second;
+        uint16_t next = field[(static_cast<size_t>(y) * width + x) * stride];
+        if (next < MAX_DISTANCE) {
+            next++;
+        }
+        for (int dir = 0; dir < 4; dir++) {
+            int nextX = x + DX[dir];
+            int nextY = y + DY[dir];
+            if (maze.isWallUnchecked(nextX, nextY)) {
+                continue;
+            }
+            uint16_t& distance = field[(static_cast<size_t>(nextY) * width + nextX) * stride];
+            if (distance == UNREACHABLE) {
+                distance = next;
+                queue.push_back({nextX, nextY});
+            }
+        }
+    }
+}
+
+int DistanceOracle::lowerBound(int ax, int ay, int bx, int by) const {
+    int bound = abs(ax - bx) + abs(ay - by);
+    if (landmarkCount > 0) {
+        const uint16_t* a = &landmarkFields[(static_cast<size_t>(ay) * width + ax) * landmarkCount];
+        const uint16_t* b = &landmarkFields[(static_cast<size_t>(by) * width + bx) * landmarkCount];
+        for (int i = 0; i < landmarkCount; i++) {
+            // A landmark that reaches only one of them says nothing useful
+            if (a[i] != UNREACHABLE && b[i] != UNREACHABLE) {
+                bound = max(bound, abs(static_cast<int>(a[i]) - static_cast<int>(b[i])));
+            }
+        }
+    }
+    
+    uint16_t ladderA = ladderField[static_cast<size_t>(ay) * width + ax];
+    uint16_t ladderB = ladderField[static_cast<size_t>(by) * width + bx];
+    if (ladderA != UNREACHABLE && ladderB != UNREACHABLE) {
+        bound = max(bound, abs(static_cast<int>(ladderA) - static_cast<int>(ladderB)));
+    }
+    return bound;
+}
+
+size_t DistanceOracle::getMemoryBytes() const {
+    size_t cells = static_cast<size_t>(width) * height;
+    return cells * (landmarkCount + 1) * sizeof(uint16_t);
+}
+
+// Sizes of the parts of a DistanceOracleSection, each padded to 8 bytes
+static size_t paddedBytes(size_t bytes) {
+    return (bytes + 7) & ~static_cast<size_t>(7);
+}
+
+void DistanceOracle::appendSection(string& out) const {
+    size_t cells = static_cast<size_t>(width) * height;
+    DistanceOracleSection header;
+    memset(&header, 0, sizeof(header));
+    header.mapHash = mapHash;
+    header.width = width;
+    header.height = height;
+    header.landmarkCount = landmarkCount;
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    
+    vector<int32_t> coordinates;
+    for (const auto& landmark : landmarks) {
+        coordinates.push_back(landmark.first);
+        coordinates.push_back(landmark.second);
+    }
+    size_t start = out.size();
+    out.append(reinterpret_cast<const char*>(coordinates.data()), coordinates.size() * sizeof(int32_t));
+    out.resize(start + paddedBytes(coordinates.size() * sizeof(int32_t)), 0);
+    
+    start = out.size();
+    out.append(reinterpret_cast<const char*>(ladderField), cells * sizeof(uint16_t));
+    out.resize(start + paddedBytes(cells * sizeof(uint16_t)), 0);
+    out.append(reinterpret_cast<const char*>(landmarkFields), cells * landmarkCount * sizeof(uint16_t));
+}
+
+shared_ptr<const DistanceOracle> DistanceOracle::findPrecomputed(const Maze& maze, uint64_t mapHash, int count) {
+    size_t cells = static_cast<size_t>(maze.getWidth()) * maze.getHeight();
+    for (const auto& section : maze.getPrecomputedSections(PRECOMPUTED_DISTANCE_ORACLE)) {
+        DistanceOracleSection header;
+        if (section.second < sizeof(header)) {
+            continue;
+        }
+        memcpy(&header, section.first, sizeof(header));
+        if (header.mapHash != mapHash || header.width != static_cast<uint32_t>(maze.getWidth()) ||
+            header.height != static_cast<uint32_t>(maze.getHeight()) ||
+            header.landmarkCount > static_cast<uint32_t>(MAX_LANDMARKS) || 
+            header.landmarkCount < static_cast<uint32_t>(count)) {
+            continue;
+        }
+        
+        size_t coordinateBytes = paddedBytes(header.landmarkCount * 2 * sizeof(int32_t));
+        size_t ladderBytes = paddedBytes(cells * sizeof(uint16_t));
+        if (section.second != sizeof(header) + coordinateBytes + ladderBytes + cells * header.landmarkCount * sizeof(uint16_t)) {
+            continue;
+        }
+        
+        shared_ptr<DistanceOracle> oracle(new DistanceOracle());
+        oracle->width = maze.getWidth();
+        oracle->height = maze.getHeight();
+        oracle->mapHash = mapHash;
+        oracle->landmarkCount = header.landmarkCount;
+        const char* part = section.first + sizeof(header);
+        for (uint32_t i = 0; i < header.landmarkCount; i++) {
+            int32_t coordinates[2];
+            memcpy(coordinates, part + i * sizeof(coordinates), sizeof(coordinates));
+            oracle->landmarks.push_back({coordinates[0], coordinates[1]});
+        }
+        part += coordinateBytes;
+        oracle->ladderField = reinterpret_cast<const uint16_t*>(part);
+        oracle->landmarkFields = reinterpret_cast<const uint16_t*>(part + ladderBytes);
+        oracle->mapping = maze.getMapping();
+        return oracle;
+    }
+    return nullptr;
+}
\ No newline at end of file
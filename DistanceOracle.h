@@ -0,0 +1,91 @@
+#ifndef DISTANCEORACLE_H
+#define DISTANCEORACLE_H
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+class Maze;
+class MappedFile;
+
+// Walking distances on one maze, precomputed by breadth-first search: an
+// exact field to the ladder and fields from K landmarks for ALT lower
+// bounds (|d(L, a) - d(L, b)| <= d(a, b) for every landmark L). Distances
+// are 16 bits per cell; longer ones are stored as MAX_DISTANCE, which
+// keeps the bounds admissible. Landmarks are spread out by farthest-point
+// selection, and the fields are interleaved per cell so a bound touches
+// one cache line per cell.
+//
+// The fields only describe the maze they were built from, a maze with
+// walls removed needs a new oracle. Oracles can be stored in the
+// precomputed data of a compiled maze (see MazeFormat.h and MapCache) and
+// are then used straight from the mapped file.
+class DistanceOracle {
+public:
+    static const uint16_t UNREACHABLE = 0xFFFF;
+    static const uint16_t MAX_DISTANCE = 0xFFFE;
+    static const int MAX_LANDMARKS = 64;
+
+    // Shared oracle for a maze with this content and at least this many
+    // landmarks, taken from the maze's precomputed data or built on first
+    // use. Thread-safe; the last few oracles are kept, so games played one
+    // after the other on a map reuse them.
+    static std::shared_ptr<const DistanceOracle> get(const Maze& maze, int landmarkCount);
+
+    DistanceOracle(const Maze& maze, int landmarkCount);
+    
+    DistanceOracle(const DistanceOracle&) = delete;
+    DistanceOracle& operator=(const DistanceOracle&) = delete;
+    
+    // The oracle for this maze in its precomputed data, nullptr if there is none
+    static std::shared_ptr<const DistanceOracle> findPrecomputed(const Maze& maze, uint64_t mapHash, 
+                                                                 int landmarkCount);
+    // Appends a DistanceOracleSection, see MazeFormat.h
+    void appendSection(std::string& out) const;
+
+    uint64_t getMapHash() const { return mapHash; }
+    int getLandmarkCount() const { return landmarkCount; }
+    std::pair<int, int> getLandmark(int index) const { return landmarks[index]; }
+
+    // UNREACHABLE outside the map, on walls and where the ladder can't be reached
+    uint16_t getLadderDistance(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) {
+            return UNREACHABLE;
+        }
+        return ladderField[static_cast<size_t>(y) * width + x];
+    }
+
+    uint16_t getLandmarkDistance(int landmark, int x, int y) const {
+        return landmarkFields[(static_cast<size_t>(y) * width + x) * landmarkCount + landmark];
+    }
+
+    // Never more than the walking distance between two open cells of the
+    // map: the Manhattan distance or the best landmark bound
+    int lowerBound(int ax, int ay, int bx, int by) const;
+
+    size_t getMemoryBytes() const;
+
+private:
+    int width, height;
+    uint64_t mapHash;
+    int landmarkCount;
+    std::vector<std::pair<int, int>> landmarks;
+    
+    // Either into the storage vectors or into a mapped file
+    const uint16_t* ladderField;
+    const uint16_t* landmarkFields;
+    std::vector<uint16_t> ladderStorage;
+    std::vector<uint16_t> landmarkStorage;
+    std::shared_ptr<const MappedFile> mapping;
+    
+    DistanceOracle() = default;
+
+    // Fills field[(y * width + x) * stride] for every cell reachable from the start
+    void breadthFirst(const Maze& maze, int startX, int startY, uint16_t* field, size_t stride,
+                      std::vector<std::pair<int, int>>& queue) const;
+};
+
+#endif
\ No newline at end of file
@@ -1,241 +1,491 @@
 #include "Game.h"
+#include "NcursesRenderer.h"
+#include "Profiler.h"
+#include "SnapshotStream.h"
+#include "PlacementMap.h"
+#include "TickTimer.h"
 #include <iostream>
+#include <sstream>
 #include <random>
 #include <algorithm>
-#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include <cstring>
 
 using namespace std;
 
-Game::Game(const string& mapFile) 
-    : maze(nullptr), gregorakis(nullptr), asimenia(nullptr), 
-      trap1(nullptr), trap2(nullptr), cage1(nullptr), cage2(nullptr),
-      key(nullptr), ladder(nullptr), turns(0), gameWon(false), gameLost(false),
+Game::Game(const string& mapFile, Renderer* gameRenderer, const GameConfig& gameConfig) 
+    : maze(nullptr), groupCount(0), trappedCount(0), activeKeys(0), decisionPool(nullptr), workerAllocations(0), teamMap(nullptr), renderer(gameRenderer), 
+      config(gameConfig), rng(gameConfig.seed), turns(0), gameWon(false), gameLost(false),
       heroesFound(false), wallsDisappearing(false), wallDisappearCounter(0),
-      movingToLadder(false) {
+      dissolveCursor(0), wallsLeft(0), wallsPerTick(1), originalMapHash(0), movingToLadder(false), speedFactor(1), stopSimulation(false), simulationDone(false),
+      recorder(nullptr) {
     
-    initializeGame(mapFile);
+    initializeGame(new Maze(mapFile));
+}
+
+Game::Game(const Maze& mapTemplate, Renderer* gameRenderer, const GameConfig& gameConfig) 
+    : maze(nullptr), groupCount(0), trappedCount(0), activeKeys(0), decisionPool(nullptr), workerAllocations(0), teamMap(nullptr), renderer(gameRenderer), 
+      config(gameConfig), rng(gameConfig.seed), turns(0), gameWon(false), gameLost(false),
+      heroesFound(false), wallsDisappearing(false), wallDisappearCounter(0),
+      dissolveCursor(0), wallsLeft(0), wallsPerTick(1), originalMapHash(0), movingToLadder(false), speedFactor(1), stopSimulation(false), simulationDone(false),
+      recorder(nullptr) {
+    
+    initializeGame(new Maze(mapTemplate));
 }
 
 Game::~Game() {
+    // Finishes the replay file
+    delete recorder;
+    delete decisionPool;
+    delete teamMap;
     delete maze;
-    delete gregorakis;
-    delete asimenia;
-    delete trap1;
-    delete trap2;
-    delete cage1;
-    delete cage2;
-    delete key;
-    delete ladder;
-    
-    endwin(); // Clean up ncurses
-}
-
-void Game::initializeGame(const string& mapFile) {
-    // Initialize ncurses
-    initscr();
-    cbreak();
-    noecho();
-    nodelay(stdscr, TRUE);
-    curs_set(0); 
-    
-    // Initialize colors
-    if (has_colors()) {
-        start_color();
-        init_pair(1, COLOR_RED, COLOR_BLACK);    // Heroes
-        init_pair(2, COLOR_YELLOW, COLOR_BLACK); // Key
-        init_pair(3, COLOR_GREEN, COLOR_BLACK);  // Ladder
-        init_pair(4, COLOR_MAGENTA, COLOR_BLACK); // Cages
-        init_pair(5, COLOR_CYAN, COLOR_BLACK);   // Info text
-    }
-    
-    // Load maze
-    maze = new Maze(mapFile);
-    
-    // Create ladder object at maze's ladder position
-    ladder = new GameObject(maze->getLadderX(), maze->getLadderY(), 'L', ObjectType::LADDER);
+    delete renderer;
+}
+
+void TrapTable::add(int trapX, int trapY) {
+    x.push_back(trapX);
+    y.push_back(trapY);
+    state.push_back(TrapState::ARMED);
+    prisoner.push_back(-1);
+}
+
+void TrapTable::clear() {
+    x.clear();
+    y.clear();
+    state.clear();
+    prisoner.clear();
+}
+
+void KeyTable::add(int keyX, int keyY) {
+    x.push_back(keyX);
+    y.push_back(keyY);
+    active.push_back(1);
+}
+
+void KeyTable::clear() {
+    x.clear();
+    y.clear();
+    active.clear();
+}
+
+void Game::initializeGame(Maze* loadedMaze) {
+    maze = loadedMaze;
+    
+    if (!renderer) {
+        renderer = new NcursesRenderer();
+    }
+    
+    for (int i = 0; i < GAME_PHASE_COUNT; i++) {
+        phaseTurns[i] = 0;
+        phaseSeconds[i] = 0.0;
+    }
+    
+    renderer->init(maze);
+    // Checkpoints name the map they belong to, hashed once here
+    originalMapHash = maze->getContentHash();
     
     // Place objects randomly
+    createTeamMap();
     placeObjectsRandomly();
     
+    if (config.decisionThreads != 1 && heroes.size() > 1) {
+        decisionPool = new ThreadPool(config.decisionThreads);
+    }
+    decisionScratch.resize(decisionPool ? decisionPool->getThreadCount() : 1);
+    
     // Initialize heroes' memory with maze dimensions
-    gregorakis->updateVision(maze);
-    asimenia->updateVision(maze);
+    for (auto& hero : heroes) {
+        hero.updateVision(maze);
+    }
+    if (teamMap) {
+        for (auto& hero : heroes) {
+            hero.syncTeamMap();
+        }
+    }
+    
+    if (!config.replayFile.empty()) {
+        recorder = new ReplayRecorder(config.replayFile, maze, config.seed, config.keyframeInterval,
+                                      heroes.size(), keys.size(), traps.size());
+        recordTurn();
+    }
 }
 
 void Game::placeObjectsRandomly() {
-    vector<pair<int, int>> freePositions;
-    
-    // Find all free positions inside the maze (not on borders)
-    for (int y = 1; y < maze->getHeight() - 1; y++) {  
-        for (int x = 1; x < maze->getWidth() - 1; x++) {   
-            if (!maze->isWall(x, y) && 
-                !(x == maze->getLadderX() && y == maze->getLadderY())) {
-                freePositions.push_back({x, y});
-            }
-        }
+    if (config.heroCount < 1) {
+        throw runtime_error("A game needs at least one hero");
+    }
+    if (config.trapCount < 0) {
+        throw runtime_error("Trap count can't be negative");
     }
+    if (config.keyCount < 0) {
+        throw runtime_error("Key count can't be negative");
+    }
+    if (config.turnLimit < 1 || config.heroSpacing < 1) {
+        throw runtime_error("Turn limit and hero spacing must be at least 1");
+    }
+    
+    // Everything starts in one connected part of the map, so the heroes
+    // can always meet and reach the keys. Usually another game on this
+    // map has found that part already.
+    size_t entityCount = static_cast<size_t>(config.heroCount) + config.trapCount + config.keyCount;
+    shared_ptr<const PlacementMap> placement = PlacementMap::get(*maze, entityCount);
     
-    if (freePositions.size() < 5) {
-        throw runtime_error("Not enough free positions in maze");
+    vector<pair<int, int>> heroCells = placement->sampleApart(rng, config.heroCount, config.heroSpacing);
+    heroes.clear();
+    heroes.reserve(config.heroCount);
+    for (const auto& cell : heroCells) {
+        addHero(cell.first, cell.second, rng.next());
     }
     
-    // Shuffle positions
-    shuffle(freePositions.begin(), freePositions.end(), default_random_engine{});
+    // Keys, then traps, on the cells left
+    vector<pair<int, int>> objectCells = placement->sample(rng, config.keyCount + config.trapCount, heroCells);
+    keys.clear();
+    for (int i = 0; i < config.keyCount; i++) {
+        keys.add(objectCells[i].first, objectCells[i].second);
+    }
+    activeKeys = config.keyCount;
     
-    // Place heroes with minimum distance of 7
-    bool validPlacement = false;
-    int attempts = 0;
-    while (!validPlacement && attempts < 1000) {
-        int pos1 = rand() % freePositions.size();
-        int pos2 = rand() % freePositions.size();
-        
-        if (pos1 != pos2) {
-            int x1 = freePositions[pos1].first;
-            int y1 = freePositions[pos1].second;
-            int x2 = freePositions[pos2].first;
-            int y2 = freePositions[pos2].second;
-            
-            if (abs(x1 - x2) >= 7 || abs(y1 - y2) >= 7) {
-                gregorakis = new Hero(x1, y1, 'G', "Gregorakis", maze->getWidth(), maze->getHeight());
-                asimenia = new Hero(x2, y2, 'S', "Asimenia", maze->getWidth(), maze->getHeight());
-                
-                // Remove used positions
-                freePositions.erase(freePositions.begin() + max(pos1, pos2));
-                freePositions.erase(freePositions.begin() + min(pos1, pos2));
-                validPlacement = true;
-            }
-        }
-        attempts++;
+    traps.clear();
+    for (int i = 0; i < config.trapCount; i++) {
+        traps.add(objectCells[config.keyCount + i].first, objectCells[config.keyCount + i].second);
     }
     
-    if (!validPlacement) {
-        throw runtime_error("Could not place heroes with required distance");
+    rebuildOccupancy();
+    
+    // Every hero starts in a group of its own
+    for (int i = 0; i < config.heroCount; i++) {
+        heroGroup[i] = i;
+    }
+    groupCount = config.heroCount;
+}
+
+void Game::addHero(int x, int y, uint64_t seed) {
+    int index = heroes.size();
+    string name = index == 0 ? "Gregorakis" : (index == 1 ? "Asimenia" : "Hero " + to_string(index + 1));
+    heroes.emplace_back(x, y, heroSymbol(index), name, maze->getWidth(), maze->getHeight(), seed);
+    heroes.back().setVision(config.visionRadius, config.lineOfSight);
+    heroes.back().setTeamMap(teamMap);
+}
+
+void Game::createTeamMap() {
+    delete teamMap;
+    teamMap = nullptr;
+    if (config.sharedMap) {
+        // Within one turn a cell changes at most once, and only inside some hero's view
+        size_t cells = static_cast<size_t>(maze->getWidth()) * maze->getHeight();
+        size_t viewCells = static_cast<size_t>(config.heroCount) * VisionTable::get(config.visionRadius).getCellsInRange();
+        teamMap = new TeamMap(maze->getWidth(), maze->getHeight(), min(cells, viewCells));
+    }
+    for (auto& hero : heroes) {
+        hero.setTeamMap(teamMap);
+    }
+}
+
+void Game::rebuildOccupancy() {
+    int heroCount = heroes.size();
+    occupancy.clear();
+    heroNext.assign(heroCount, -1);
+    heroPrev.assign(heroCount, -1);
+    heroGroup.resize(heroCount);
+    trappedCount = 0;
+    for (int i = 0; i < heroCount; i++) {
+        linkHeroToCell(i);
+        if (heroes[i].getIsTrapped()) {
+            trappedCount++;
+        }
     }
     
-    // Place remaining objects
-    if (freePositions.size() >= 3) {
-        // Place key
-        int keyPos = rand() % freePositions.size();
-        key = new GameObject(freePositions[keyPos].first, freePositions[keyPos].second, 'K', ObjectType::KEY);
-        freePositions.erase(freePositions.begin() + keyPos);
-        
-        // Place traps
-        int trap1Pos = rand() % freePositions.size();
-        trap1 = new GameObject(freePositions[trap1Pos].first, freePositions[trap1Pos].second, 'T', ObjectType::TRAP);
-        freePositions.erase(freePositions.begin() + trap1Pos);
-        
-        int trap2Pos = rand() % freePositions.size();
-        trap2 = new GameObject(freePositions[trap2Pos].first, freePositions[trap2Pos].second, 'T', ObjectType::TRAP);
+    activeKeys = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (keys.active[i]) {
+            occupancy.get(cellKey(keys.x[i], keys.y[i])).key = i;
+            activeKeys++;
+        }
+    }
+    // Open cages stay in the index, a trap cell never takes another trap
+    for (size_t i = 0; i < traps.size(); i++) {
+        occupancy.get(cellKey(traps.x[i], traps.y[i])).trap = i;
+    }
+}
+
+void Game::linkHeroToCell(int hero) {
+    OccupancyIndex::Cell& cell = occupancy.get(cellKey(heroes[hero].getX(), heroes[hero].getY()));
+    heroPrev[hero] = -1;
+    heroNext[hero] = cell.firstHero;
+    if (cell.firstHero >= 0) {
+        heroPrev[cell.firstHero] = hero;
+    }
+    cell.firstHero = hero;
+}
+
+void Game::unlinkHeroFromCell(int hero) {
+    long long key = cellKey(heroes[hero].getX(), heroes[hero].getY());
+    if (heroPrev[hero] >= 0) {
+        heroNext[heroPrev[hero]] = heroNext[hero];
+    } else {
+        occupancy.get(key).firstHero = heroNext[hero];
+    }
+    if (heroNext[hero] >= 0) {
+        heroPrev[heroNext[hero]] = heroPrev[hero];
+    }
+    heroNext[hero] = -1;
+    heroPrev[hero] = -1;
+    occupancy.release(key);
+}
+
+void Game::moveHero(int hero, int x, int y) {
+    unlinkHeroFromCell(hero);
+    heroes[hero].setPosition(x, y);
+    linkHeroToCell(hero);
+}
+
+void Game::pickUpKey(int key) {
+    long long cell = cellKey(keys.x[key], keys.y[key]);
+    keys.active[key] = 0;
+    activeKeys--;
+    occupancy.get(cell).key = -1;
+    occupancy.release(cell);
+}
+
+int Game::findGroup(int hero) {
+    while (heroGroup[hero] != hero) {
+        heroGroup[hero] = heroGroup[heroGroup[hero]]; // Path halving
+        hero = heroGroup[hero];
+    }
+    return hero;
+}
+
+void Game::joinGroups(int first, int second) {
+    int a = findGroup(first);
+    int b = findGroup(second);
+    if (a != b) {
+        // The lower index becomes the root, so the result never depends on the order of joins
+        heroGroup[max(a, b)] = min(a, b);
+        groupCount--;
+    }
+}
+
+void Game::joinHeroesOnSameCell() {
+    for (size_t i = 0; i < heroes.size(); i++) {
+        if (heroes[i].getIsTrapped()) {
+            continue;
+        }
+        const OccupancyIndex::Cell* cell = occupancy.find(cellKey(heroes[i].getX(), heroes[i].getY()));
+        for (int other = cell->firstHero; other >= 0; other = heroNext[other]) {
+            if (other != static_cast<int>(i) && !heroes[other].getIsTrapped()) {
+                joinGroups(i, other);
+                break; // The rest of the cell joins through this one
+            }
+        }
+    }
+}
+
+bool Game::allHeroesAt(int x, int y) const {
+    const OccupancyIndex::Cell* cell = occupancy.find(cellKey(x, y));
+    int count = 0;
+    for (int hero = cell ? cell->firstHero : -1; hero >= 0; hero = heroNext[hero]) {
+        count++;
     }
+    return count == static_cast<int>(heroes.size());
 }
 
 void Game::updateDisplay() {
-    clear();
-    
-    // Display maze
-    maze->display();
+    PROFILE_SCOPE(ProfileTimer::DISPLAY);
+    buildFrame();
+    renderer->drawFrame(maze, frame);
+    frame.changedCells.clear();
+}
+
+void Game::buildFrame() {
+    frame.turn = turns;
+    frame.sprites.clear();
     
     // Display objects
-    if (key && key->isActive()) {
-        attron(COLOR_PAIR(2));
-        mvaddch(key->getY(), key->getX(), key->getSymbol());
-        attroff(COLOR_PAIR(2));
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (keys.active[i]) {
+            frame.sprites.push_back({keys.x[i], keys.y[i], 'K', 2});
+        }
     }
     
     // Display the traps for Users
-    if (trap1 && trap1->isActive() && trap1->getType() == ObjectType::TRAP) {
-        attron(COLOR_PAIR(4));
-        mvaddch(trap1->getY(), trap1->getX(), 'T');
-        attroff(COLOR_PAIR(4));
-    }
-
-    if (trap2 && trap2->isActive() && trap2->getType() == ObjectType::TRAP) {
-        attron(COLOR_PAIR(4)); 
-        mvaddch(trap2->getY(), trap2->getX(), 'T');
-        attroff(COLOR_PAIR(4));
+    for (size_t i = 0; i < traps.size(); i++) {
+        if (traps.state[i] == TrapState::ARMED) {
+            frame.sprites.push_back({traps.x[i], traps.y[i], 'T', 4});
+        }
     }
     
     // Display cages when activated
-    if (cage1 && cage1->isVisible()) {
-        attron(COLOR_PAIR(4));
-        mvaddch(cage1->getY(), cage1->getX(), cage1->getSymbol());
-        attroff(COLOR_PAIR(4));
-    }
-    
-    if (cage2 && cage2->isVisible()) {
-        attron(COLOR_PAIR(4));
-        mvaddch(cage2->getY(), cage2->getX(), cage2->getSymbol());
-        attroff(COLOR_PAIR(4));
+    for (size_t i = 0; i < traps.size(); i++) {
+        if (traps.state[i] == TrapState::CAGE) {
+            frame.sprites.push_back({traps.x[i], traps.y[i], 'C', 4});
+        }
     }
     
     // Display heroes
-    if (gregorakis && !gregorakis->getIsTrapped()) {
-        attron(COLOR_PAIR(1));
-        mvaddch(gregorakis->getY(), gregorakis->getX(), gregorakis->getSymbol());
-        attroff(COLOR_PAIR(1));
-    }
-    
-    if (asimenia && !asimenia->getIsTrapped()) {
-        attron(COLOR_PAIR(1));
-        mvaddch(asimenia->getY(), asimenia->getX(), asimenia->getSymbol());
-        attroff(COLOR_PAIR(1));
+    for (size_t i = 0; i < heroes.size(); i++) {
+        if (!heroes[i].getIsTrapped()) {
+            frame.sprites.push_back({heroes[i].getX(), heroes[i].getY(), heroes[i].getSymbol(), 1});
+        }
     }
 
-    attron(COLOR_PAIR(5));
     if (wallsDisappearing) {
-        mvprintw(maze->getHeight() + 4, 0, "Heroes found! Walls disappearing...");
+        frame.status = "Heroes found! Walls disappearing...";
     } else if (movingToLadder) {
-        mvprintw(maze->getHeight() + 4, 0, "Moving to the ladder...");
+        frame.status = "Moving to the ladder...";
+    } else {
+        frame.status.clear();
     }
-    attroff(COLOR_PAIR(5));
-    
-    refresh();
 }
 
 bool Game::isCagePosition(int x, int y) const {
-    if (cage1 && cage1->isVisible() && cage1->isActive() && 
-        cage1->getType() == ObjectType::CAGE &&
-        cage1->getX() == x && cage1->getY() == y) {
-        return true;
-    }
+    const OccupancyIndex::Cell* cell = occupancy.find(cellKey(x, y));
+    return cell && cell->trap >= 0 && traps.state[cell->trap] == TrapState::CAGE;
+}
+
+void Game::processHeroTurns() {
+    int heroCount = heroes.size();
+    heroIntents.resize(heroCount);
+    heroDecided.assign(heroCount, 0);
     
-    if (cage2 && cage2->isVisible() && cage2->isActive() && 
-        cage2->getType() == ObjectType::CAGE &&
-        cage2->getX() == x && cage2->getY() == y) {
-        return true;
+    // The journal is complete before anyone reads it
+    if (teamMap) {
+        teamMap->clearJournal();
+        forEachHero([this](int index, int) {
+            if (!heroes[index].getIsTrapped()) {
+                heroes[index].updateVision(maze);
+            }
+        });
     }
     
-    return false;
+    forEachHero([this](int index, int worker) {
+        decideHeroMove(index, worker);
+    });
+    
+    for (int i = 0; i < heroCount; i++) {
+        resolveHeroMove(i);
+    }
+}
+
+void Game::forEachHero(const function<void(int, int)>& task) {
+    int heroCount = heroes.size();
+    if (decisionPool) {
+#ifndef MAZE_NO_PROFILE
+        // Allocations are counted per thread, step() sees only worker 0's
+        decisionPool->parallelFor(heroCount, [this, &task](int index, int worker) {
+            uint64_t allocationsBefore = Profiler::threadAllocations();
+            task(index, worker);
+            if (worker > 0) {
+                decisionScratch[worker].allocations += Profiler::threadAllocations() - allocationsBefore;
+            }
+        });
+#else
+        decisionPool->parallelFor(heroCount, task);
+#endif
+    } else {
+        for (int i = 0; i < heroCount; i++) {
+            task(i, 0);
+        }
+    }
 }
 
-void Game::processHeroTurn(Hero* hero) {
-    if (hero->getIsTrapped()) { // Trapped heroes can't move
+uint64_t Game::collectWorkerAllocations() {
+    uint64_t allocations = 0;
+    for (DecisionScratch& scratch : decisionScratch) {
+        allocations += scratch.allocations;
+        scratch.allocations = 0;
+    }
+    workerAllocations += allocations;
+    return allocations;
+}
+
+void Game::decideHeroMove(int index, int worker) {
+    // Only this hero changes here, everything else is read-only until all heroes decided
+    PROFILE_SCOPE(ProfileTimer::HERO_TURN);
+    Hero& hero = heroes[index];
+    // Trapped heroes still hear what the others found
+    hero.syncTeamMap();
+    if (hero.getIsTrapped()) { // Trapped heroes can't move
         return; 
     }
     
-    // Update hero's vision
-    hero->updateVision(maze);
+    // Update hero's vision, with a team map that was done already
+    if (!teamMap) {
+        hero.updateVision(maze);
+    }
+    
+    DecisionScratch& scratch = decisionScratch[worker];
+    int visibleKey = -1;
+    findVisibleEntities(hero, scratch, visibleKey);
     
     // Get next move
     int keyX = -1, keyY = -1;
-    if (key && key->isActive() && hero->canSeePosition(key->getX(), key->getY())) {
-        keyX = key->getX();
-        keyY = key->getY();
+    if (visibleKey >= 0) {
+        keyX = keys.x[visibleKey];
+        keyY = keys.y[visibleKey];
     }
     
-    vector<pair<int, int>> visibleCages;
-    if (cage1 && cage1->isVisible() && cage1->isActive() && 
-        hero->canSeePosition(cage1->getX(), cage1->getY())) {
-        visibleCages.push_back({cage1->getX(), cage1->getY()});
+    // In trap order, like the heroes always saw them
+    sort(scratch.cageIds.begin(), scratch.cageIds.end());
+    scratch.cages.clear();
+    for (int trap : scratch.cageIds) {
+        scratch.cages.push_back({traps.x[trap], traps.y[trap]});
     }
-    if (cage2 && cage2->isVisible() && cage2->isActive() && 
-        hero->canSeePosition(cage2->getX(), cage2->getY())) {
-        visibleCages.push_back({cage2->getX(), cage2->getY()});
+    
+    heroIntents[index] = hero.decideNextMove(maze, keyX, keyY, scratch.cages);
+    heroDecided[index] = 1;
+}
+
+void Game::findVisibleEntities(const Hero& hero, DecisionScratch& scratch, int& visibleKey) const {
+    scratch.cageIds.clear();
+    int radius = hero.getVisionRadius();
+    long long windowCells = static_cast<long long>(2 * radius + 1) * (2 * radius + 1);
+    
+    // A small view is cheaper to look up cell by cell in the occupancy
+    // index, a wide one with few entities by testing every key and trap
+    if (windowCells <= static_cast<long long>(keys.size() + traps.size())) {
+        for (int y = hero.getY() - radius; y <= hero.getY() + radius; y++) {
+            for (int x = hero.getX() - radius; x <= hero.getX() + radius; x++) {
+                if (!maze->isValidPosition(x, y) || !hero.canSeePosition(x, y)) {
+                    continue;
+                }
+                const OccupancyIndex::Cell* cell = occupancy.find(cellKey(x, y));
+                if (!cell) {
+                    continue;
+                }
+                if (cell->key >= 0 && (visibleKey < 0 || cell->key < visibleKey)) {
+                    visibleKey = cell->key;
+                }
+                if (cell->trap >= 0 && traps.state[cell->trap] == TrapState::CAGE) {
+                    scratch.cageIds.push_back(cell->trap);
+                }
+            }
+        }
+        return;
     }
     
-    pair<int, int> nextMove = hero->decideNextMove(maze, keyX, keyY, visibleCages);
+    // Tables are in index order, so the first key seen is the lowest
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (keys.active[i] && hero.canSeePosition(keys.x[i], keys.y[i])) {
+            visibleKey = i;
+            break;
+        }
+    }
+    for (size_t i = 0; i < traps.size(); i++) {
+        if (traps.state[i] == TrapState::CAGE && hero.canSeePosition(traps.x[i], traps.y[i])) {
+            scratch.cageIds.push_back(i);
+        }
+    }
+}
+
+void Game::resolveHeroMove(int index) {
+    if (!heroDecided[index]) {
+        return;
+    }
+    Hero& hero = heroes[index];
+    pair<int, int> nextMove = heroIntents[index];
     
-    // Validate move
+    // Validate move against the state left by the heroes resolved before
     bool canMove = true;
     
     // Check if it's a valid maze position
@@ -244,157 +494,186 @@ void Game::processHeroTurn(Hero* hero) {
     }
     
     if (canMove && isCagePosition(nextMove.first, nextMove.second)) {
-        if (!hero->getHasKey()) {
+        if (!hero.getHasKey()) {
             canMove = false;  // Cannot enter cage without key
         }
     }
     
     // Execute move if valid
     if (canMove) {
-        hero->setPosition(nextMove.first, nextMove.second);
-        checkCollisions(hero);
+        moveHero(index, nextMove.first, nextMove.second);
+        checkCollisions(index);
     }
     else {
-        hero->notifyBlockedMove(nextMove.first, nextMove.second);
+        hero.notifyBlockedMove(nextMove.first, nextMove.second);
     }
 }
 
-void Game::checkCollisions(Hero* hero) {
-    int heroX = hero->getX();
-    int heroY = hero->getY();
+void Game::checkCollisions(int index) {
+    PROFILE_SCOPE(ProfileTimer::COLLISIONS);
+    Hero& hero = heroes[index];
+    const OccupancyIndex::Cell* cell = occupancy.find(cellKey(hero.getX(), hero.getY()));
+    int trap = cell->trap;
     
-    // Check key collision
-    if (key && key->isActive() && key->getX() == heroX && key->getY() == heroY) {
-        hero->setHasKey(true);
-        key->setActive(false);
+    // Check key collision, a hero carries one key at a time
+    if (cell->key >= 0 && !hero.getHasKey()) {
+        hero.setHasKey(true);
+        pickUpKey(cell->key);
     }
     
-    // Check trap collisions, traps are not visible to heroes
-    if (trap1 && trap1->getType() == ObjectType::TRAP && trap1->isActive() &&
-        trap1->getX() == heroX && trap1->getY() == heroY) {
-        trap1->triggerTrap(); // Trap to Cage
-        hero->setTrapped(true);
-        cage1 = trap1;
+    if (trap < 0) {
+        return;
     }
     
-    if (trap2 && trap2->getType() == ObjectType::TRAP && trap2->isActive() &&
-        trap2->getX() == heroX && trap2->getY() == heroY) {
-        trap2->triggerTrap();
-        hero->setTrapped(true);
-        cage2 = trap2;
+    // Check trap collisions, traps are not visible to heroes
+    if (traps.state[trap] == TrapState::ARMED) {
+        traps.state[trap] = TrapState::CAGE; // Trap to Cage
+        traps.prisoner[trap] = index;
+        hero.setTrapped(true);
+        trappedCount++;
     }
+    
     // Key opens the cage only from the same position 
-    if (hero->getHasKey() && !hero->getIsTrapped()) {
+    int prisoner = traps.prisoner[trap];
+    if (hero.getHasKey() && !hero.getIsTrapped() &&
+        traps.state[trap] == TrapState::CAGE && prisoner != index) {
+        heroes[prisoner].setTrapped(false);
+        trappedCount--;
+        traps.state[trap] = TrapState::OPEN;
+        traps.prisoner[trap] = -1;
         
-        Hero* otherHero = (hero == gregorakis) ? asimenia : gregorakis;
+        hero.setHasKey(false); // Key consumed
+        moveHero(prisoner, hero.getX(), hero.getY());
+        joinGroups(index, prisoner);
         
-        if (otherHero->getIsTrapped()) {
-            bool rescued = false;
-            
-            if (cage1 && cage1->isVisible() && cage1->isActive() &&
-                heroX == cage1->getX() && heroY == cage1->getY() &&
-                otherHero->getX() == cage1->getX() && otherHero->getY() == cage1->getY()) {
-                otherHero->setTrapped(false);
-                cage1->setActive(false);
-                cage1->setVisible(false);
-                rescued = true;
-            }
-            
-            if (!rescued && cage2 && cage2->isVisible() && cage2->isActive() &&
-                heroX == cage2->getX() && heroY == cage2->getY() &&
-                otherHero->getX() == cage2->getX() && otherHero->getY() == cage2->getY()) {
-                otherHero->setTrapped(false);
-                cage2->setActive(false);
-                cage2->setVisible(false);
-                rescued = true;
-            }
-            
-            if (rescued) {
-                hero->setHasKey(false); // Key consumed
-				otherHero->setPosition(heroX, heroY);
-                if (!heroesFound && 
-                    gregorakis->getX() == asimenia->getX() && 
-                    gregorakis->getY() == asimenia->getY() &&
-                    !gregorakis->getIsTrapped() && !asimenia->getIsTrapped()) {
-                    
-                    heroesFound = true;
-                    startWallDisappearing();
-                }
-            }
+        if (!heroesFound && allHeroesTogether()) {
+            heroesFound = true;
+            startWallDisappearing();
         }
     }
 }
 
 void Game::checkGameConditions() {
+    PROFILE_SCOPE(ProfileTimer::GAME_CONDITIONS);
     if (heroesFound && !wallsDisappearing && 
-        gregorakis->getX() == ladder->getX() && gregorakis->getY() == ladder->getY() &&
-        asimenia->getX() == ladder->getX() && asimenia->getY() == ladder->getY()) {
+        allHeroesAt(maze->getLadderX(), maze->getLadderY())) {
         gameWon = true;
         return;
     }
 	
     // Check if heroes are together 
-    if (!heroesFound && 
-        gregorakis->getX() == asimenia->getX() && 
-        gregorakis->getY() == asimenia->getY() &&
-        !gregorakis->getIsTrapped() && !asimenia->getIsTrapped()) {
-        heroesFound = true;
-        startWallDisappearing();
-        return;
+    if (!heroesFound) {
+        joinHeroesOnSameCell();
+        if (allHeroesTogether()) {
+            heroesFound = true;
+            startWallDisappearing();
+            return;
+        }
     }
     
     // Check if game is lost
-    if (turns >= 1000) {
+    if (turns >= config.turnLimit) {
         gameLost = true;
         return;
     }
     
-    // Check if both heroes are trapped with no way to escape
-    if (gregorakis->getIsTrapped() && asimenia->getIsTrapped()) {
+    // Check if all heroes are trapped with no way to escape
+    if (trappedCount == static_cast<int>(heroes.size())) {
         gameLost = true;
         return;
     }
     
-    // Check if one hero is trapped and the other doesn't have the key
-    // and the key is not accessible (losing condition)
-    if ((gregorakis->getIsTrapped() && !asimenia->getHasKey()) ||
-        (asimenia->getIsTrapped() && !gregorakis->getHasKey())) {
-        // Additional check if the key is still available
-        if (!key || !key->isActive()) {
-            gameLost = true;
-            return;
+    // Check if a hero is trapped and nobody can get a key to the cage
+    // (losing condition)
+    if (trappedCount > 0 && activeKeys == 0) {
+        for (const Hero& hero : heroes) {
+            if (hero.getHasKey() && !hero.getIsTrapped()) {
+                return;
+            }
         }
+        gameLost = true;
+        return;
     }
 }
 
 void Game::startWallDisappearing() {
     wallsDisappearing = true;
+    beginDissolve();
+    
+    ostringstream message;
+    message << "Heroes found! Walls disappearing... Total internal walls: " << wallsLeft;
+    renderer->logMessage(message.str());
+}
+
+void Game::beginDissolve() {
     wallDisappearCounter = 0;
-    wallsToRemove.clear();
+    dissolveCursor = 0;
+    wallsLeft = maze->countWalls(1, 1, maze->getWidth() - 2, maze->getHeight() - 2);
     
-    for (int y = 1; y < maze->getHeight() - 1; y++) {
-        for (int x = 1; x < maze->getWidth() - 1; x++) {
-            if (maze->isWall(x, y)) {
-                wallsToRemove.push_back({x, y});
+    switch (config.dissolveMode) {
+        case DissolveMode::ALL_AT_ONCE:
+            wallsPerTick = max(wallsLeft, 1);
+            break;
+        case DissolveMode::TIMED: {
+            int ticks = max(config.dissolveTicks, 1);
+            wallsPerTick = max((wallsLeft + ticks - 1) / ticks, 1);
+            break;
+        }
+        default:
+            wallsPerTick = max(config.dissolveRate, 1);
+            break;
+    }
+}
+
+void Game::dissolveWalls(int count) {
+    count = min(count, wallsLeft);
+    int minX = 1, minY = 1;
+    int maxX = maze->getWidth() - 2, maxY = maze->getHeight() - 2;
+    bool trackCells = renderer->wantsFrames() || recorder;
+    
+    if (count == wallsLeft) {
+        // The rest goes in one bulk clear, cells are only listed when someone draws or records them
+        if (trackCells) {
+            maze->forEachWall(minX, minY, maxX, maxY, [&](int x, int y) {
+                if (renderer->wantsFrames()) {
+                    frame.changedCells.push_back({x, y});
+                }
+                if (recorder) {
+                    turnRemovedWalls.push_back({x, y});
+                }
+            });
+        }
+        maze->clearWalls(minX, minY, maxX, maxY);
+    } else {
+        for (int i = 0; i < count; i++) {
+            int x = dissolveCursor % maze->getWidth();
+            int y = dissolveCursor / maze->getWidth();
+            if (!maze->findNextWall(minX, minY, maxX, maxY, x, y)) {
+                break;
+            }
+            maze->removeWall(x, y);
+            dissolveCursor = static_cast<long long>(y) * maze->getWidth() + x + 1;
+            if (renderer->wantsFrames()) {
+                frame.changedCells.push_back({x, y});
+            }
+            if (recorder) {
+                turnRemovedWalls.push_back({x, y});
             }
         }
-    }  
-    cout << "Heroes found! Walls disappearing... Total internal walls: " 
-              << wallsToRemove.size() << endl;
+    }
+    
+    wallDisappearCounter += count;
+    wallsLeft -= count;
+    if (wallsLeft == 0) {
+        dissolveCursor = static_cast<long long>(maze->getWidth()) * maze->getHeight();
+    }
 }
 
 void Game::updateWallDisappearing() {
+    PROFILE_SCOPE(ProfileTimer::WALL_DISAPPEARING);
     if (!wallsDisappearing) return;
-    if (wallDisappearCounter < wallsToRemove.size()) {
-        int wallIndex = wallDisappearCounter;
-        int x = wallsToRemove[wallIndex].first;
-        int y = wallsToRemove[wallIndex].second;
-        
-        maze->removeWall(x, y);
-        wallDisappearCounter++;
-        
-        cout << "Wall disappeared at (" << x << "," << y << ") - " 
-                  << wallDisappearCounter << "/" << wallsToRemove.size() << endl;
+    if (wallsLeft > 0) {
+        dissolveWalls(wallsPerTick);
     } else {
         // The inside walls disappeared
         wallsDisappearing = false;
@@ -404,41 +683,64 @@ void Game::updateWallDisappearing() {
 
 void Game::startMovingToLadder() {
     movingToLadder = true;
-    cout << "Heroes now moving to ladder using shortest path..." << endl;
+    renderer->logMessage("Heroes now moving to ladder using shortest path...");
 }
 
 void Game::moveHeroesToLadder() {
+    PROFILE_SCOPE(ProfileTimer::MOVE_TO_LADDER);
     if (!movingToLadder) return;
     
-    int ladderX = ladder->getX();
-    int ladderY = ladder->getY();
-    
-    int gX = gregorakis->getX();
-    int gY = gregorakis->getY();
-    
-    if (gX != ladderX) {
-        gX += (ladderX > gX) ? 1 : -1;
-    } else if (gY != ladderY) {
-        gY += (ladderY > gY) ? 1 : -1;
+    // The walls are gone for good now, usually another game on this map
+    // built the field already
+    if (!ladderOracle) {
+        ladderOracle = DistanceOracle::get(*maze, 0);
     }
     
-    gregorakis->setPosition(gX, gY);
-    
-    int aX = asimenia->getX();
-    int aY = asimenia->getY();
+    for (size_t i = 0; i < heroes.size(); i++) {
+        moveHeroToLadder(i);
+    }
     
-    if (aX != ladderX) {
-        aX += (ladderX > aX) ? 1 : -1;
-    } else if (aY != ladderY) {
-        aY += (ladderY > aY) ? 1 : -1;
+    // Check if they all reached the ladder
+    if (allHeroesAt(maze->getLadderX(), maze->getLadderY())) {
+        gameWon = true;
+    }
+}
+
+void Game::moveHeroToLadder(int index) {
+    const Hero& hero = heroes[index];
+    int x = hero.getX();
+    int y = hero.getY();
+    int distance = ladderOracle->getLadderDistance(x, y);
+    if (distance == 0 || distance == DistanceOracle::UNREACHABLE) {
+        return;
     }
     
-    asimenia->setPosition(aX, aY);
+    // Downhill on the ladder field. Of the neighbours one step closer the
+    // first of up, left, right, down is taken, like A* does on open floor.
+    static const int dx[] = {0, -1, 1, 0};
+    static const int dy[] = {-1, 0, 0, 1};
+    if (distance < DistanceOracle::MAX_DISTANCE) {
+        for (int dir = 0; dir < 4; dir++) {
+            if (ladderOracle->getLadderDistance(x + dx[dir], y + dy[dir]) == distance - 1) {
+                moveHero(index, x + dx[dir], y + dy[dir]);
+                return;
+            }
+        }
+        return;
+    }
     
-    // Check if they are both reached the ladder
-    if (gregorakis->getX() == ladderX && gregorakis->getY() == ladderY &&
-        asimenia->getX() == ladderX && asimenia->getY() == ladderY) {
-        gameWon = true;
+    // Too far for the 16-bit field. Only the border is left after the
+    // dissolve, so the Manhattan distance is the walking distance here.
+    int ladderX = maze->getLadderX();
+    int ladderY = maze->getLadderY();
+    int manhattan = manhattanDistance(x, y, ladderX, ladderY);
+    for (int dir = 0; dir < 4; dir++) {
+        int nextX = x + dx[dir];
+        int nextY = y + dy[dir];
+        if (isValidPosition(nextX, nextY) && manhattanDistance(nextX, nextY, ladderX, ladderY) == manhattan - 1) {
+            moveHero(index, nextX, nextY);
+            return;
+        }
     }
 }
 
@@ -447,69 +749,467 @@ bool Game::isValidPosition(int x, int y) {
 }
 
 bool Game::isPositionOccupied(int x, int y) {
-    if (gregorakis && gregorakis->getX() == x && gregorakis->getY() == y) return true;
-    if (asimenia && asimenia->getX() == x && asimenia->getY() == y) return true;
-    if (key && key->isActive() && key->getX() == x && key->getY() == y) return true;
-    if (trap1 && trap1->isActive() && trap1->getX() == x && trap1->getY() == y) return true;
-    if (trap2 && trap2->isActive() && trap2->getX() == x && trap2->getY() == y) return true;
-    if (ladder && ladder->getX() == x && ladder->getY() == y) return true;
-    return false;
+    if (x == maze->getLadderX() && y == maze->getLadderY()) return true;
+    const OccupancyIndex::Cell* cell = occupancy.find(cellKey(x, y));
+    if (!cell) return false;
+    return cell->firstHero >= 0 || cell->key >= 0 || 
+           (cell->trap >= 0 && traps.state[cell->trap] != TrapState::OPEN);
 }
 
 int Game::manhattanDistance(int x1, int y1, int x2, int y2) {
     return abs(x1 - x2) + abs(y1 - y2);
 }
 
-void Game::run() {
+bool Game::step() {
+    if (isGameOver()) {
+        return false;
+    }
+    
+    GamePhase phase = getPhase();
+    auto phaseStart = chrono::steady_clock::now();
+#ifndef MAZE_NO_PROFILE
+    uint64_t allocationsBefore = Profiler::threadAllocations();
+#endif
+    
+    // Process game phases
+    if (wallsDisappearing) {
+        updateWallDisappearing();
+    } else if (movingToLadder) {
+        moveHeroesToLadder();
+    } else {
+        // Normal gameplay
+        processHeroTurns();
+    }
+    
+    // Check game conditions
+    checkGameConditions();
+    
+    turns++;
+    
+    int phaseIndex = static_cast<int>(phase);
+    phaseTurns[phaseIndex]++;
+    phaseSeconds[phaseIndex] += chrono::duration<double>(chrono::steady_clock::now() - phaseStart).count();
+    
+    PROFILE_COUNT(ProfileCounter::TURNS, 1);
+#ifndef MAZE_NO_PROFILE
+    uint64_t workerDelta = collectWorkerAllocations();
+    PROFILE_COUNT(ProfileCounter::ALLOCATIONS, Profiler::threadAllocations() - allocationsBefore + workerDelta);
+#endif
+    
+    if (recorder) {
+        recordTurn();
+    }
+    
+    if (!config.checkpointFile.empty() && config.checkpointInterval > 0 && 
+        (turns % config.checkpointInterval == 0 || isGameOver())) {
+        saveSnapshot(config.checkpointFile);
+    }
+    
+    return !isGameOver();
+}
+
+GameResult Game::runToCompletion() {
+    bool drawing = renderer->wantsFrames();
     while (!isGameOver()) {
+        if (drawing) {
+            updateDisplay();
+        }
+        step();
+    }
+    if (drawing) {
         updateDisplay();
+        renderer->showResult(maze, gameWon);
+    }
+    return getResult();
+}
+
+void Game::publishFrame() {
+    buildFrame();
+    
+    lock_guard<mutex> lock(frameMutex);
+    publishedFrame.turn = frame.turn;
+    publishedFrame.sprites = frame.sprites;
+    publishedFrame.status = frame.status;
+    
+    // Keep changes the render thread has not seen yet
+    publishedFrame.changedCells.insert(publishedFrame.changedCells.end(), 
+                                       frame.changedCells.begin(), frame.changedCells.end());
+    frame.changedCells.clear();
+}
+
+void Game::simulationLoop() {
+    // Each tick is due one delay after the previous one was due, not after
+    // this step finished, so the time spent stepping doesn't add up.
+    // A step slower than the delay starts the count again.
+    auto nextTick = chrono::steady_clock::now();
+    while (!stopSimulation && !isGameOver()) {
+        step();
+        publishFrame();
         
-        // Process game phases
-        if (wallsDisappearing) {
-            updateWallDisappearing();
-        } else if (movingToLadder) {
-            moveHeroesToLadder();
+        int factor = speedFactor;
+        if (factor > 0) {
+            // Timer for walls and players
+            chrono::microseconds delay = (wallsDisappearing || movingToLadder) 
+                                         ? chrono::microseconds(50000)    // 50ms
+                                         : chrono::microseconds(130000);  // 130ms
+            auto now = chrono::steady_clock::now();
+            nextTick = max(nextTick + delay / factor, now);
+            unique_lock<mutex> lock(frameMutex);
+            if (speedChanged.wait_until(lock, nextTick, [this, factor] {
+                    return stopSimulation || speedFactor != factor;
+                })) {
+                nextTick = chrono::steady_clock::now();
+            }
         } else {
-            // Normal gameplay
-            processHeroTurn(gregorakis);
-            processHeroTurn(asimenia);
+            nextTick = chrono::steady_clock::now();
         }
+    }
+    simulationDone = true;
+}
+
+void Game::setSpeed(int factor) {
+    {
+        lock_guard<mutex> lock(frameMutex);
+        speedFactor = factor;
+    }
+    speedChanged.notify_all();
+}
+
+void Game::run() {
+    const int framesPerSecond = 30;
+    const chrono::microseconds frameInterval(1000000 / framesPerSecond);
+    
+    // The simulation changes the real maze, the display works on a copy
+    // that only sees the changes delivered with each frame
+    Maze displayMaze(*maze);
+    RenderFrame drawn;
+    
+    // Woken by the frame timer or by a key, so keys take effect at once
+    // and nothing runs between frames
+    TickTimer frameTimer(frameInterval);
+    int inputFd = renderer->getInputFd();
+    
+    publishFrame();
+    thread simulation(&Game::simulationLoop, this);
+    
+    bool quit = false;
+    while (!quit) {
+        bool finished = simulationDone;
         
-        // Check game conditions
-        checkGameConditions();
-        
-        turns++;
+        {
+            lock_guard<mutex> lock(frameMutex);
+            drawn.turn = publishedFrame.turn;
+            drawn.sprites = publishedFrame.sprites;
+            drawn.status = publishedFrame.status;
+            drawn.changedCells.swap(publishedFrame.changedCells);
+            publishedFrame.changedCells.clear();
+        }
         
-        // Timer for walls and players
-        if (wallsDisappearing || movingToLadder) {
-            usleep(50000); // 50ms
-        } else {
-            usleep(130000); // 130ms
+        for (const auto& cell : drawn.changedCells) {
+            displayMaze.removeWall(cell.first, cell.second);
         }
         
-        // Check for user input to quit
-        int ch = getch();
-        if (ch == 'q' || ch == 'Q') {
+        int factor = speedFactor;
+        string speedLabel = factor > 0 ? "Speed " + to_string(factor) + "x" : "Speed max";
+        drawn.status = drawn.status.empty() ? speedLabel : drawn.status + "  " + speedLabel;
+        
+        renderer->drawFrame(&displayMaze, drawn);
+        drawn.changedCells.clear();
+        
+        if (finished) {
             break;
         }
+        
+        frameTimer.wait(inputFd);
+        
+        // Handle every key that arrived since the last frame
+        int ch;
+        while ((ch = renderer->readKey()) != -1) {
+            if (ch == 'q' || ch == 'Q') {
+                quit = true;
+            } else if (ch == '1') {
+                setSpeed(1);
+            } else if (ch == '2') {
+                setSpeed(10);
+            } else if (ch == '3') {
+                setSpeed(0);
+            } else if (ch == 'p' || ch == 'P') {
+                try {
+                    Profiler::reportToFile();
+                } catch (const exception& e) {
+                    renderer->logMessage(e.what());
+                }
+            }
+        }
     }
     
+    {
+        lock_guard<mutex> lock(frameMutex);
+        stopSimulation = true;
+    }
+    speedChanged.notify_all();
+    simulation.join();
+    
     // Display final result
-    clear();
-    if (gameWon) {
-        attron(COLOR_PAIR(3));
-        mvprintw(maze->getHeight()/2, maze->getWidth()/2 - 15, "Congratulations! The heroes saved the kingdom!");
-        attroff(COLOR_PAIR(3));
-    } else {
-        attron(COLOR_PAIR(1));
-        mvprintw(maze->getHeight()/2, maze->getWidth()/2 - 12, "Game Over! The kingdom has fallen...");
-        attroff(COLOR_PAIR(1));
+    renderer->showResult(&displayMaze, gameWon);
+}
+
+static ReplayEntityState heroReplayState(const Hero& hero) {
+    uint8_t flags = 0;
+    if (hero.getHasKey()) {
+        flags |= REPLAY_HAS_KEY;
+    }
+    if (hero.getIsTrapped()) {
+        flags |= REPLAY_TRAPPED;
+    }
+    return {hero.getX(), hero.getY(), flags};
+}
+
+static ReplayEntityState trapReplayState(int x, int y, TrapState state) {
+    switch (state) {
+        case TrapState::ARMED:
+            return {x, y, REPLAY_ACTIVE};
+        case TrapState::CAGE:
+            return {x, y, static_cast<uint8_t>(REPLAY_ACTIVE | REPLAY_VISIBLE | REPLAY_CAGE)};
+        default:
+            return {x, y, REPLAY_CAGE};
+    }
+}
+
+void Game::recordTurn() {
+    replayState.turn = turns;
+    replayState.phase = static_cast<uint8_t>(getPhase());
+    replayState.outcome = gameWon ? REPLAY_WON : (gameLost ? REPLAY_LOST : REPLAY_RUNNING);
+    replayState.entities.clear();
+    for (const Hero& hero : heroes) {
+        replayState.entities.push_back(heroReplayState(hero));
+    }
+    for (size_t i = 0; i < keys.size(); i++) {
+        replayState.entities.push_back({keys.x[i], keys.y[i], static_cast<uint8_t>(keys.active[i] ? REPLAY_ACTIVE : 0)});
+    }
+    for (size_t i = 0; i < traps.size(); i++) {
+        replayState.entities.push_back(trapReplayState(traps.x[i], traps.y[i], traps.state[i]));
     }
-    mvprintw(maze->getHeight()/2 + 2, maze->getWidth()/2 - 12, "Press any key to exit...");
-    refresh();
     
-    nodelay(stdscr, FALSE);
-    getch();
+    recorder->recordTurn(replayState, turnRemovedWalls, maze);
+    turnRemovedWalls.clear();
+}
+
+void Game::saveSnapshot(const string& filename) const {
+    SnapshotWriter out;
+    out.putU32(turns);
+    out.putI32(config.turnLimit);
+    out.putU8(gameWon);
+    out.putU8(gameLost);
+    out.putU8(heroesFound);
+    out.putU8(wallsDisappearing);
+    out.putU8(movingToLadder);
+    out.putI32(wallDisappearCounter);
+    for (int i = 0; i < GAME_PHASE_COUNT; i++) {
+        out.putI32(phaseTurns[i]);
+        out.putDouble(phaseSeconds[i]);
+    }
+    
+    uint64_t rngState[4];
+    rng.getState(rngState);
+    out.putBytes(rngState, sizeof(rngState));
+    
+    // Maze diff: the dissolve removes walls in a fixed order, so the
+    // position reached is enough to repeat it on the original map
+    out.putU64(dissolveCursor);
+    out.putI32(wallsPerTick);
+    
+    out.putU32(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        out.putI32(keys.x[i]);
+        out.putI32(keys.y[i]);
+        out.putU8(keys.active[i]);
+    }
+    
+    out.putU32(traps.size());
+    for (size_t i = 0; i < traps.size(); i++) {
+        out.putI32(traps.x[i]);
+        out.putI32(traps.y[i]);
+        out.putU8(static_cast<uint8_t>(traps.state[i]));
+        out.putI32(traps.prisoner[i]);
+    }
+    
+    // Group parents as they are, the heroes follow
+    out.putU32(heroes.size());
+    for (size_t i = 0; i < heroes.size(); i++) {
+        out.putI32(heroGroup[i]);
+    }
+    out.putI32(config.visionRadius);
+    out.putU8(config.lineOfSight);
+    out.putU8(teamMap != nullptr);
+    if (teamMap) {
+        teamMap->save(out);
+    }
+    for (const Hero& hero : heroes) {
+        hero.saveState(out);
+    }
+    
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.width = maze->getWidth();
+    header.height = maze->getHeight();
+    header.mapHash = originalMapHash;
+    header.seed = config.seed;
+    out.writeFile(filename, header);
+}
+
+void Game::loadSnapshot(const string& filename) {
+    if (turns != 0 || recorder) {
+        throw runtime_error("Snapshots can only be loaded into a new game that is not being recorded");
+    }
+    
+    SnapshotReader in(filename);
+    const SnapshotHeader& header = in.getHeader();
+    if (header.width != static_cast<uint32_t>(maze->getWidth()) || 
+        header.height != static_cast<uint32_t>(maze->getHeight()) ||
+        header.mapHash != originalMapHash) {
+        throw runtime_error("Snapshot " + filename + " was taken on a different map");
+    }
+    config.seed = header.seed;
+    
+    turns = in.getU32();
+    config.turnLimit = in.getI32();
+    if (config.turnLimit < 1) {
+        throw runtime_error("Corrupt snapshot file");
+    }
+    gameWon = in.getU8() != 0;
+    gameLost = in.getU8() != 0;
+    heroesFound = in.getU8() != 0;
+    wallsDisappearing = in.getU8() != 0;
+    movingToLadder = in.getU8() != 0;
+    wallDisappearCounter = in.getI32();
+    for (int i = 0; i < GAME_PHASE_COUNT; i++) {
+        phaseTurns[i] = in.getI32();
+        phaseSeconds[i] = in.getDouble();
+    }
+    
+    uint64_t rngState[4];
+    in.getBytes(rngState, sizeof(rngState));
+    rng.setState(rngState);
+    
+    // Repeat the dissolve up to the saved position
+    uint64_t cursor = in.getU64();
+    int perTick = in.getI32();
+    if (heroesFound) {
+        int removed = wallDisappearCounter;
+        beginDissolve();
+        if (removed < 0 || removed > wallsLeft || perTick < 1) {
+            throw runtime_error("Corrupt snapshot file");
+        }
+        dissolveWalls(removed);
+        wallsPerTick = perTick;
+    } else if (wallDisappearCounter != 0 || cursor != 0) {
+        throw runtime_error("Corrupt snapshot file");
+    }
+    if (cursor != static_cast<uint64_t>(dissolveCursor)) {
+        throw runtime_error("Corrupt snapshot file");
+    }
+    
+    keys.clear();
+    uint32_t keyCount = in.getU32();
+    for (uint32_t i = 0; i < keyCount; i++) {
+        int x = in.getI32();
+        int y = in.getI32();
+        if (!maze->isValidPosition(x, y)) {
+            throw runtime_error("Corrupt snapshot file");
+        }
+        keys.add(x, y);
+        keys.active[i] = in.getU8() != 0;
+    }
+    
+    traps.clear();
+    uint32_t trapCount = in.getU32();
+    for (uint32_t i = 0; i < trapCount; i++) {
+        int x = in.getI32();
+        int y = in.getI32();
+        uint8_t state = in.getU8();
+        if (!maze->isValidPosition(x, y) || state > static_cast<uint8_t>(TrapState::OPEN)) {
+            throw runtime_error("Corrupt snapshot file");
+        }
+        traps.add(x, y);
+        traps.state[i] = static_cast<TrapState>(state);
+        traps.prisoner[i] = in.getI32();
+    }
+    
+    uint32_t heroCount = in.getU32();
+    if (heroCount < 1 || heroCount > maze->getWidth() * static_cast<uint64_t>(maze->getHeight())) {
+        throw runtime_error("Corrupt snapshot file");
+    }
+    heroGroup.resize(heroCount);
+    groupCount = 0;
+    for (uint32_t i = 0; i < heroCount; i++) {
+        heroGroup[i] = in.getI32();
+        // Parents always have a lower index, so there are no cycles
+        if (heroGroup[i] < 0 || heroGroup[i] > static_cast<int>(i)) {
+            throw runtime_error("Corrupt snapshot file");
+        }
+        if (heroGroup[i] == static_cast<int>(i)) {
+            groupCount++;
+        }
+    }
+    for (int prisoner : traps.prisoner) {
+        if (prisoner < -1 || prisoner >= static_cast<int>(heroCount)) {
+            throw runtime_error("Corrupt snapshot file");
+        }
+    }
+    
+    int radius = in.getI32();
+    if (radius < 1 || radius > VisionTable::MAX_RADIUS) {
+        throw runtime_error("Corrupt snapshot file");
+    }
+    config.visionRadius = radius;
+    config.lineOfSight = in.getU8() != 0;
+    config.sharedMap = in.getU8() != 0;
+    config.heroCount = heroCount;
+    createTeamMap();
+    if (teamMap) {
+        teamMap->load(in);
+    }
+    
+    heroes.clear();
+    heroes.reserve(heroCount);
+    for (uint32_t i = 0; i < heroCount; i++) {
+        addHero(0, 0, 0);
+        heroes[i].loadState(in);
+    }
+    
+    if (!in.atEnd()) {
+        throw runtime_error("Corrupt snapshot file");
+    }
+    
+    config.heroCount = heroCount;
+    config.keyCount = keyCount;
+    config.trapCount = trapCount;
+    rebuildOccupancy();
+}
+
+GamePhase Game::getPhase() const {
+    if (wallsDisappearing) {
+        return GamePhase::WALLS_DISAPPEARING;
+    }
+    if (movingToLadder) {
+        return GamePhase::MOVING_TO_LADDER;
+    }
+    return GamePhase::EXPLORING;
+}
+
+GameResult Game::getResult() const {
+    GameResult result;
+    result.won = gameWon;
+    result.lost = gameLost;
+    result.turns = turns;
+    for (int i = 0; i < GAME_PHASE_COUNT; i++) {
+        result.phaseTurns[i] = phaseTurns[i];
+        result.phaseSeconds[i] = phaseSeconds[i];
+    }
+    return result;
 }
 
 bool Game::isGameOver() const {
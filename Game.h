@@ -3,22 +3,165 @@
 
 #include <vector>
 #include <string>
-#include <ncurses.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 #include "Maze.h"
 #include "Hero.h"
-#include "GameObject.h"
+#include "OccupancyIndex.h"
+#include "Renderer.h"
+#include "Rng.h"
+#include "ReplayRecorder.h"
+#include "ThreadPool.h"
+#include "TeamMap.h"
+#include "DistanceOracle.h"
+
+enum class GamePhase {
+    EXPLORING,
+    WALLS_DISAPPEARING,
+    MOVING_TO_LADDER
+};
+
+const int GAME_PHASE_COUNT = 3;
+
+// How the inner walls disappear once the heroes have met
+enum class DissolveMode {
+    ALL_AT_ONCE,
+    PER_TICK,      // GameConfig::dissolveRate walls every turn
+    TIMED          // spread evenly over GameConfig::dissolveTicks turns
+};
+
+// Settings for one game. The same seed on the same map replays the same game.
+struct GameConfig {
+    uint64_t seed;
+    
+    // Entities placed at the start
+    int heroCount = 2;
+    int trapCount = 2;
+    int keyCount = 1;
+    
+    // Rules: the game is lost after turnLimit turns, and heroes start at
+    // least heroSpacing cells apart in x or y
+    int turnLimit = 1000;
+    int heroSpacing = 7;
+    
+    // Threads for the hero decisions of one turn, 1 decides on the calling
+    // thread and 0 uses every core. The result is the same for any value.
+    int decisionThreads = 1;
+    
+    // How far heroes see, up to VisionTable::MAX_RADIUS. Without line of
+    // sight they see every cell in range, walls included; with it walls
+    // hide what lies behind them.
+    int visionRadius = 1;
+    bool lineOfSight = false;
+    
+    // Heroes share what they have seen and where they have been through
+    // a TeamMap instead of each exploring on their own
+    bool sharedMap = false;
+    
+    DissolveMode dissolveMode = DissolveMode::PER_TICK;
+    int dissolveRate = 1;
+    int dissolveTicks = 50;
+    
+    // Records the game to this file when set, see ReplayFormat.h
+    std::string replayFile;
+    int keyframeInterval = 64;
+    
+    // Saves a snapshot to this file every checkpointInterval turns when set
+    std::string checkpointFile;
+    int checkpointInterval = 100;
+    
+    GameConfig() : seed(Rng::randomSeed()) {}
+    explicit GameConfig(uint64_t gameSeed) : seed(gameSeed) {}
+};
+
+// A trap turns into a closed cage when a hero steps on it, and stays
+// open once a hero with a key frees the prisoner
+enum class TrapState : uint8_t {
+    ARMED,
+    CAGE,
+    OPEN
+};
+
+// Entity tables in structure-of-arrays layout, indexed by entity number
+struct TrapTable {
+    std::vector<int> x;
+    std::vector<int> y;
+    std::vector<TrapState> state;
+    std::vector<int> prisoner;    // trapped hero, -1 when none
+    
+    size_t size() const { return x.size(); }
+    void add(int trapX, int trapY);
+    void clear();
+};
+
+struct KeyTable {
+    std::vector<int> x;
+    std::vector<int> y;
+    std::vector<uint8_t> active;  // cleared when picked up
+    
+    size_t size() const { return x.size(); }
+    void add(int keyX, int keyY);
+    void clear();
+};
+
+// Outcome of a finished game, returned by Game::runToCompletion
+struct GameResult {
+    bool won;
+    bool lost;
+    int turns;
+    
+    // Indexed by GamePhase
+    int phaseTurns[GAME_PHASE_COUNT];
+    double phaseSeconds[GAME_PHASE_COUNT];
+};
 
 class Game {
 private:
     Maze* maze;
-    Hero* gregorakis;
-    Hero* asimenia;
-    GameObject* trap1;
-    GameObject* trap2;
-    GameObject* cage1;
-    GameObject* cage2;
-    GameObject* key;
-    GameObject* ladder;
+    
+    // Heroes live in one pool, the extra per-hero game state next to it.
+    // Heroes on the same cell form a doubly linked list starting at
+    // OccupancyIndex::Cell::firstHero.
+    std::vector<Hero> heroes;
+    std::vector<int> heroNext;
+    std::vector<int> heroPrev;
+    std::vector<int> heroGroup;   // union-find parent, heroes that met share a root
+    int groupCount;
+    int trappedCount;
+    
+    TrapTable traps;
+    KeyTable keys;
+    int activeKeys;
+    OccupancyIndex occupancy;
+    
+    // Normal turns run in two phases. First every free hero decides on a
+    // move, possibly in parallel, while the world is only read; the moves
+    // are kept in heroIntents. Then the moves are applied in hero order,
+    // so conflicts (two heroes on one trap or key) always end the same way.
+    struct DecisionScratch {
+        std::vector<int> cageIds;
+        std::vector<std::pair<int, int>> cages;
+        uint64_t allocations = 0;                   // on this worker since the last step()
+    };
+    std::vector<std::pair<int, int>> heroIntents;
+    std::vector<uint8_t> heroDecided;
+    std::vector<DecisionScratch> decisionScratch;   // one per worker
+    ThreadPool* decisionPool;                       // nullptr when deciding on one thread
+    uint64_t workerAllocations;                     // see getWorkerAllocations()
+    
+    // With a shared map the heroes first all look around and publish,
+    // then all read the journal back and decide, see TeamMap
+    TeamMap* teamMap;                               // nullptr unless config.sharedMap
+    
+    Renderer* renderer;
+    RenderFrame frame;
+    GameConfig config;
+    Rng rng;
+    
+    // Distances on the map left after the dissolve, for the walk to the ladder
+    std::shared_ptr<const DistanceOracle> ladderOracle;
     
     int turns;
     bool gameWon;
@@ -27,20 +170,71 @@ private:
     bool wallsDisappearing;
     int wallDisappearCounter;
     
+    // The dissolve walks over the inner walls in row-major order, the
+    // cursor is the cell index (y * width + x) to continue from
+    long long dissolveCursor;
+    int wallsLeft;
+    int wallsPerTick;
+    uint64_t originalMapHash;   // the map as loaded, for snapshots
+    
     // Μεταβλητές για τη φάση μετακίνησης προς σκάλα
     bool movingToLadder;
-    std::vector<std::pair<int, int>> wallsToRemove;
     
-    void initializeGame(const std::string& mapFile);
+    // Interactive mode: the simulation thread publishes a copy of its
+    // frame here and the render thread picks it up at its own pace
+    std::mutex frameMutex;
+    std::condition_variable speedChanged;
+    RenderFrame publishedFrame;
+    std::atomic<int> speedFactor;    // 1x, 10x..., 0 means as fast as possible
+    std::atomic<bool> stopSimulation;
+    std::atomic<bool> simulationDone;
+    
+    int phaseTurns[GAME_PHASE_COUNT];
+    double phaseSeconds[GAME_PHASE_COUNT];
+    
+    // Replay recording, nullptr unless config.replayFile is set
+    ReplayRecorder* recorder;
+    ReplayState replayState;
+    std::vector<std::pair<int, int>> turnRemovedWalls;
+    
+    void initializeGame(Maze* loadedMaze);
     void placeObjectsRandomly();
     void updateDisplay();
-    void processHeroTurn(Hero* hero);
+    void buildFrame();
+    void publishFrame();
+    void simulationLoop();
+    void setSpeed(int factor);
+    void processHeroTurns();
+    void forEachHero(const std::function<void(int, int)>& task);
+    uint64_t collectWorkerAllocations();
+    void createTeamMap();
+    void decideHeroMove(int hero, int worker);
+    void resolveHeroMove(int hero);
+    void findVisibleEntities(const Hero& hero, DecisionScratch& scratch, int& visibleKey) const;
     void checkGameConditions();
-    void checkCollisions(Hero* hero);
+    void checkCollisions(int hero);
     void startWallDisappearing();
+    void beginDissolve();
+    void dissolveWalls(int count);
     void updateWallDisappearing();
     void moveHeroesToLadder();
+    void moveHeroToLadder(int hero);
     void startMovingToLadder();
+    void recordTurn();
+    
+    // Occupancy and hero groups
+    long long cellKey(int x, int y) const { return static_cast<long long>(y) * maze->getWidth() + x; }
+    void addHero(int x, int y, uint64_t seed);
+    void linkHeroToCell(int hero);
+    void unlinkHeroFromCell(int hero);
+    void moveHero(int hero, int x, int y);
+    void pickUpKey(int key);
+    void rebuildOccupancy();
+    int findGroup(int hero);
+    void joinGroups(int first, int second);
+    void joinHeroesOnSameCell();
+    bool allHeroesTogether() const { return groupCount == 1 && trappedCount == 0; }
+    bool allHeroesAt(int x, int y) const;
     
     bool isCagePosition(int x, int y) const;
     
@@ -49,10 +243,42 @@ private:
     int manhattanDistance(int x1, int y1, int x2, int y2);
     
 public:
-    Game(const std::string& mapFile);
+    // Game takes ownership of the renderer, nullptr means ncurses
+    Game(const std::string& mapFile, Renderer* gameRenderer = nullptr, 
+         const GameConfig& gameConfig = GameConfig());
+    // Plays on a private copy of an already loaded maze
+    Game(const Maze& mapTemplate, Renderer* gameRenderer = nullptr, 
+         const GameConfig& gameConfig = GameConfig());
     ~Game();
     
+    // Interactive mode: the simulation runs on its own thread at the
+    // selected speed while this thread renders at a fixed frame rate.
+    // Keys: 1 = normal speed, 2 = 10x, 3 = maximum, p = write the
+    // profile report (see Profiler), q = quit.
     void run();
+    
+    // Headless API: advance one turn, or play until the game ends
+    bool step();
+    GameResult runToCompletion();
+    
+    // Checkpoints, see SnapshotFormat.h. loadSnapshot only works on a game
+    // that has not started yet, created from the same map; if it throws
+    // the game is left half restored and should be discarded.
+    void saveSnapshot(const std::string& filename) const;
+    void loadSnapshot(const std::string& filename);
+    
+    // Gregorakis and Asimenia, then lowercase letters for extra heroes
+    static char heroSymbol(int index) {
+        return index == 0 ? 'G' : (index == 1 ? 'S' : static_cast<char>('a' + (index - 2) % 26));
+    }
+    
+    GamePhase getPhase() const;
+    GameResult getResult() const;
+    int getTurns() const { return turns; }
+    uint64_t getSeed() const { return config.seed; }
+    // Allocations the decision workers made besides the thread calling
+    // step(), over the whole game; always 0 with -DMAZE_NO_PROFILE
+    uint64_t getWorkerAllocations() const { return workerAllocations; }
     bool isGameOver() const;
     bool isGameWon() const;
 };
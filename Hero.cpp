@@ -1,24 +1,23 @@
 #include "Hero.h"
 #include "Maze.h"
+#include "Profiler.h"
+#include "SnapshotStream.h"
 #include <algorithm>
-#include <random>
 #include <cstdlib>
 #include <cmath>
+#include <stdexcept>
 
 using namespace std;
 
-Hero::Hero(int startX, int startY, char sym, const string& heroName, int mWidth, int mHeight) 
+Hero::Hero(int startX, int startY, char sym, const string& heroName, int mWidth, int mHeight,
+           uint64_t seed) 
     : x(startX), y(startY), symbol(sym), name(heroName), hasKey(false), isTrapped(false),
-      mapWidth(mWidth), mapHeight(mHeight), lastMove({0, 0}), 
-      previousPosition({startX, startY}), stuckCounter(0) {
+      memory(mWidth, mHeight), mapWidth(mWidth), mapHeight(mHeight), lastMove({0, 0}), 
+      previousPosition({startX, startY}), stuckCounter(0), rng(seed),
+      knownMinX(startX), knownMinY(startY), knownMaxX(startX), knownMaxY(startY),
+      vision(&VisionTable::get(1)), lineOfSight(false), visionX(-1), visionY(-1), team(nullptr) {
     
-    // Initialize memory systems
-    visited.resize(mapHeight);
-    knownMap.resize(mapHeight);
-    for (int i = 0; i < mapHeight; i++) {
-        visited[i].resize(mapWidth, false);
-        knownMap[i].resize(mapWidth, '?'); // Unknown areas
-    }
+    // Memory starts all unknown, tiles are allocated as the hero explores
 }
 
 Hero::~Hero() {
@@ -61,6 +60,7 @@ bool Hero::isRepeatingMove(int targetX, int targetY) const {
 }
 
 void Hero::notifyBlockedMove(int blockedX, int blockedY) {
+    PROFILE_COUNT(ProfileCounter::BLOCKED_MOVES, 1);
     for (const auto& pos : blockedPositions) {
         if (pos.first == blockedX && pos.second == blockedY) {
             return; 
@@ -82,44 +82,188 @@ bool Hero::isBlockedPosition(int x, int y) const {
     return false;
 }
 
+void Hero::setVision(int radius, bool useLineOfSight) {
+    vision = &VisionTable::get(radius);
+    lineOfSight = useLineOfSight;
+    visionX = -1;
+    visibleCells.clear();
+}
+
+void Hero::computeLineOfSight(const Maze* maze) {
+    const int radius = vision->getRadius();
+    const int side = vision->getSide();
+    visibleCells.assign(side * side, 0);
+    visibleCells[vision->getCenter()] = 2;
+    
+    // Parents come earlier in sight order, so one pass is enough
+    for (int cell : vision->getSightOrder()) {
+        bool seen = false;
+        for (const int* parent = vision->parentsBegin(cell); parent != vision->parentsEnd(cell); ++parent) {
+            if (visibleCells[*parent] == 2) {
+                seen = true;
+                break;
+            }
+        }
+        if (seen) {
+            int cellX = x + cell % side - radius;
+            int cellY = y + cell / side - radius;
+            visibleCells[cell] = maze->isWall(cellX, cellY) ? 1 : 2;
+        }
+    }
+}
+
 void Hero::updateVision(const Maze* maze) {
-    for (int dy = -1; dy <= 1; dy++) {
-        for (int dx = -1; dx <= 1; dx++) {
-            int checkX = x + dx;
-            int checkY = y + dy;
+    const int radius = vision->getRadius();
+    PROFILE_COUNT(ProfileCounter::CELLS_SCANNED, vision->getCellsInRange());
+    
+    if (lineOfSight) {
+        computeLineOfSight(maze);
+    }
+    visionX = x;
+    visionY = y;
+    
+    // Each row of the view is merged 64 cells at a time straight from the
+    // maze words, only the cells that changed need a frontier update
+    for (int dy = -radius; dy <= radius; dy++) {
+        int rowY = y + dy;
+        if (rowY < 0 || rowY >= mapHeight) {
+            continue;
+        }
+        int rowMinX = max(0, x + vision->getRowMin(dy));
+        int rowMaxX = min(mapWidth - 1, x + vision->getRowMax(dy));
+        
+        for (int chunkX = rowMinX; chunkX <= rowMaxX; chunkX += 64) {
+            int chunkEnd = min(rowMaxX, chunkX + 63);
+            uint64_t columns = ~0ULL;
+            if (lineOfSight) {
+                columns = 0;
+                int first = vision->index(chunkX - x, dy);
+                for (int i = 0; i <= chunkEnd - chunkX; i++) {
+                    if (visibleCells[first + i] != 0) {
+                        columns |= 1ULL << i;
+                    }
+                }
+            }
             
-            if (maze->isValidPosition(checkX, checkY)) {
-                knownMap[checkY][checkX] = maze->getCell(checkX, checkY);
+            uint64_t walls = maze->getWallBits(chunkX, rowY, chunkEnd - chunkX + 1);
+            uint64_t changed = memory.mergeRow(rowY, chunkX, chunkEnd, walls, columns);
+            // Everything else the hero knows is in the team map already
+            if (team && changed) {
+                team->publishRow(rowY, chunkX, chunkEnd, walls, changed);
+            }
+            while (changed) {
+                refreshFrontier(chunkX + __builtin_ctzll(changed), rowY);
+                changed &= changed - 1;
             }
         }
     }
+    
+    knownMinX = max(0, min(knownMinX, x - radius));
+    knownMinY = max(0, min(knownMinY, y - radius));
+    knownMaxX = min(mapWidth - 1, max(knownMaxX, x + radius));
+    knownMaxY = min(mapHeight - 1, max(knownMaxY, y + radius));
+}
+
+void Hero::syncTeamMap() {
+    size_t entries = team ? team->getJournalSize() : 0;
+    for (size_t i = 0; i < entries; i++) {
+        uint64_t entry = team->getJournalEntry(i);
+        long long cell = static_cast<long long>(entry >> 2);
+        int cellX = cell % mapWidth;
+        int cellY = cell / mapWidth;
+        if (memory.setCode(cellX, cellY, entry & 3)) {
+            refreshFrontier(cellX, cellY);
+            knownMinX = min(knownMinX, cellX);
+            knownMinY = min(knownMinY, cellY);
+            knownMaxX = max(knownMaxX, cellX);
+            knownMaxY = max(knownMaxY, cellY);
+        }
+    }
+}
+
+bool Hero::isFrontierCell(int cellX, int cellY) const {
+    if (getKnownCell(cellX, cellY) != ' ') {
+        return false;
+    }
+    // getKnownCell reports out of bounds as wall, never as unknown
+    return getKnownCell(cellX, cellY - 1) == '?' || getKnownCell(cellX + 1, cellY) == '?' ||
+           getKnownCell(cellX, cellY + 1) == '?' || getKnownCell(cellX - 1, cellY) == '?';
+}
+
+void Hero::refreshFrontier(int cellX, int cellY) {
+    // Only the changed cell and its neighbours can change frontier status
+    static const int dx[] = {0, 0, 1, 0, -1};
+    static const int dy[] = {0, -1, 0, 1, 0};
+    
+    for (int i = 0; i < 5; i++) {
+        int nx = cellX + dx[i];
+        int ny = cellY + dy[i];
+        if (nx < 0 || nx >= mapWidth || ny < 0 || ny >= mapHeight) {
+            continue;
+        }
+        long long cellKey = static_cast<long long>(ny) * mapWidth + nx;
+        if (isFrontierCell(nx, ny)) {
+            frontier.insert(cellKey);
+        } else {
+            frontier.erase(cellKey);
+        }
+    }
+}
+
+pair<int, int> Hero::moveTowardsFrontier() {
+    if (frontier.empty()) {
+        return {x, y};
+    }
+    
+    // Frontier cells are inside the known area, search only there
+    return pathfinder.findNextStepToNearest(knownMinX, knownMinY, knownMaxX, knownMaxY, x, y,
+        [this](int cellX, int cellY) {
+            return memory.getCode(cellX, cellY) == HeroMemory::OPEN && !isBlockedPosition(cellX, cellY);
+        },
+        [this](int cellX, int cellY) {
+            return frontier.count(static_cast<long long>(cellY) * mapWidth + cellX) > 0;
+        });
 }
 
 void Hero::markVisited(int posX, int posY) {
     if (posX >= 0 && posX < mapWidth && posY >= 0 && posY < mapHeight) {
-        visited[posY][posX] = true;
+        memory.markVisited(posX, posY);
+        if (team) {
+            team->markVisited(posX, posY);
+        }
     }
 }
 
 bool Hero::hasVisited(int posX, int posY) const {
     if (posX >= 0 && posX < mapWidth && posY >= 0 && posY < mapHeight) {
-        return visited[posY][posX];
+        return memory.isVisited(posX, posY) || (team && team->isVisited(posX, posY));
     }
     return false;
 }
 
 char Hero::getKnownCell(int posX, int posY) const {
     if (posX >= 0 && posX < mapWidth && posY >= 0 && posY < mapHeight) {
-        return knownMap[posY][posX];
+        return memory.getCell(posX, posY);
     }
     return '*'; // Assume wall if out of bounds
 }
 
 bool Hero::canSeePosition(int targetX, int targetY) const {
-    return abs(targetX - x) <= 1 && abs(targetY - y) <= 1;
+    int dx = targetX - x;
+    int dy = targetY - y;
+    int radius = vision->getRadius();
+    if (abs(dx) > radius || abs(dy) > radius || !vision->inRange(vision->index(dx, dy))) {
+        return false;
+    }
+    // Before the first updateVision from here only the range is known
+    if (lineOfSight && visionX == x && visionY == y) {
+        return visibleCells[vision->index(dx, dy)] != 0;
+    }
+    return true;
 }
 
 vector<pair<int, int>> Hero::getValidMoves(const Maze* maze) const {
+    PROFILE_COUNT(ProfileCounter::MOVES_EVALUATED, 4);
     vector<pair<int, int>> moves;
     
     // Check all 4 directions
@@ -130,7 +274,8 @@ vector<pair<int, int>> Hero::getValidMoves(const Maze* maze) const {
         int newX = x + dx[i];
         int newY = y + dy[i];
         
-        if (maze->isValidPosition(newX, newY) && !maze->isWall(newX, newY)) {
+        // The maze border makes out-of-map neighbours walls
+        if (!maze->isWallUnchecked(newX, newY)) {
             moves.push_back({newX, newY});
         }
     }
@@ -150,7 +295,7 @@ pair<int, int> Hero::exploreUnknown(const Maze* maze) {
     }
     
     if (!unexploredMoves.empty()) {
-        return unexploredMoves[rand() % unexploredMoves.size()];
+        return unexploredMoves[rng.nextInt(unexploredMoves.size())];
     }
     
     // If all nearby positions visited, try to find path to unexplored areas
@@ -174,15 +319,15 @@ pair<int, int> Hero::exploreUnknownSmart(const Maze* maze) {
     }
     
     if (!unexploredMoves.empty()) {
-        return unexploredMoves[rand() % unexploredMoves.size()];
+        return unexploredMoves[rng.nextInt(unexploredMoves.size())];
     }
 
     if (!nonRepeatingMoves.empty()) {
-        return nonRepeatingMoves[rand() % nonRepeatingMoves.size()];
+        return nonRepeatingMoves[rng.nextInt(nonRepeatingMoves.size())];
     }
 
     if (!validMoves.empty()) {
-        return validMoves[rand() % validMoves.size()];
+        return validMoves[rng.nextInt(validMoves.size())];
     }
     
     return {x, y};
@@ -206,23 +351,54 @@ pair<int, int> Hero::exploreUnknownSmartWithBlocked(const Maze* maze) {
     
     // Priority to Unexplored areas
     if (!unexploredMoves.empty()) {
-        return unexploredMoves[rand() % unexploredMoves.size()];
+        return unexploredMoves[rng.nextInt(unexploredMoves.size())];
+    }
+    
+    // Everything nearby is visited, head for the closest unknown edge
+    pair<int, int> frontierMove = moveTowardsFrontier();
+    if (frontierMove.first != x || frontierMove.second != y) {
+        return frontierMove;
     }
     
     // If all moves have been explored, select from the non-repeating ones 
     if (!nonRepeatingMoves.empty()) {
-        return nonRepeatingMoves[rand() % nonRepeatingMoves.size()];
+        return nonRepeatingMoves[rng.nextInt(nonRepeatingMoves.size())];
     }
     
     // If all repeat or are blocked, choose randomly from the valid ones
     if (!validMoves.empty()) {
-        return validMoves[rand() % validMoves.size()];
+        return validMoves[rng.nextInt(validMoves.size())];
     }
     
     return {x, y}; 
 }
 
 pair<int, int> Hero::moveTowardsTarget(int targetX, int targetY, const Maze* maze) {
+    // Plan on what the hero knows, unknown cells are assumed open.
+    // The search stays in a small box around hero and target.
+    const int margin = 8;
+    int minX = max(0, min(x, targetX) - margin);
+    int minY = max(0, min(y, targetY) - margin);
+    int maxX = min(mapWidth - 1, max(x, targetX) + margin);
+    int maxY = min(mapHeight - 1, max(y, targetY) + margin);
+    
+    pair<int, int> step = pathfinder.findNextStep(minX, minY, maxX, maxY, x, y, targetX, targetY,
+        [this, targetX, targetY](int cellX, int cellY) {
+            if (memory.getCode(cellX, cellY) == HeroMemory::WALL) {
+                return false;
+            }
+            return (cellX == targetX && cellY == targetY) || !isBlockedPosition(cellX, cellY);
+        });
+    
+    if (step.first != x || step.second != y) {
+        return step;
+    }
+    
+    // No known path, fall back to closing the distance
+    return greedyMoveTowardsTarget(targetX, targetY, maze);
+}
+
+pair<int, int> Hero::greedyMoveTowardsTarget(int targetX, int targetY, const Maze* maze) {
     vector<pair<int, int>> validMoves = getValidMoves(maze);
     
     if (validMoves.empty()) {
@@ -251,7 +427,7 @@ pair<int, int> Hero::randomValidMove(const Maze* maze) {
         return {x, y}; 
     }
     
-    return validMoves[rand() % validMoves.size()];
+    return validMoves[rng.nextInt(validMoves.size())];
 }
 
 pair<int, int> Hero::smartRandomMove(const Maze* maze) {
@@ -265,11 +441,11 @@ pair<int, int> Hero::smartRandomMove(const Maze* maze) {
     }
     
     if (!smartMoves.empty()) {
-        return smartMoves[rand() % smartMoves.size()];
+        return smartMoves[rng.nextInt(smartMoves.size())];
     }
     
     if (!validMoves.empty()) {
-        return validMoves[rand() % validMoves.size()];
+        return validMoves[rng.nextInt(validMoves.size())];
     }
     
     return {x, y}; 
@@ -287,11 +463,11 @@ pair<int, int> Hero::smartRandomMoveWithBlocked(const Maze* maze) {
     }
     
     if (!smartMoves.empty()) {
-        return smartMoves[rand() % smartMoves.size()];
+        return smartMoves[rng.nextInt(smartMoves.size())];
     }
 
     if (!validMoves.empty()) {
-        return validMoves[rand() % validMoves.size()];
+        return validMoves[rng.nextInt(validMoves.size())];
     }
     
     return {x, y}; 
@@ -333,4 +509,86 @@ pair<int, int> Hero::decideNextMove(const Maze* maze, int keyX, int keyY,
 
 bool Hero::isAdjacent(int otherX, int otherY) const {
     return abs(x - otherX) <= 1 && abs(y - otherY) <= 1;
+}
+
+void Hero::saveState(SnapshotWriter& out) const {
+    out.putI32(x);
+    out.putI32(y);
+    out.putU8(hasKey);
+    out.putU8(isTrapped);
+    out.putI32(lastMove.first);
+    out.putI32(lastMove.second);
+    out.putI32(previousPosition.first);
+    out.putI32(previousPosition.second);
+    out.putI32(stuckCounter);
+    
+    uint64_t rngState[4];
+    rng.getState(rngState);
+    out.putBytes(rngState, sizeof(rngState));
+    
+    out.putU32(blockedPositions.size());
+    for (const auto& pos : blockedPositions) {
+        out.putI32(pos.first);
+        out.putI32(pos.second);
+    }
+    
+    // Sorted so equal heroes give equal files
+    vector<long long> frontierCells(frontier.begin(), frontier.end());
+    sort(frontierCells.begin(), frontierCells.end());
+    out.putU64(frontierCells.size());
+    for (long long cell : frontierCells) {
+        out.putU64(cell);
+    }
+    
+    out.putI32(knownMinX);
+    out.putI32(knownMinY);
+    out.putI32(knownMaxX);
+    out.putI32(knownMaxY);
+    memory.save(out);
+}
+
+void Hero::loadState(SnapshotReader& in) {
+    x = in.getI32();
+    y = in.getI32();
+    hasKey = in.getU8() != 0;
+    isTrapped = in.getU8() != 0;
+    lastMove.first = in.getI32();
+    lastMove.second = in.getI32();
+    previousPosition.first = in.getI32();
+    previousPosition.second = in.getI32();
+    stuckCounter = in.getI32();
+    if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight) {
+        throw runtime_error("Corrupt snapshot file");
+    }
+    
+    uint64_t rngState[4];
+    in.getBytes(rngState, sizeof(rngState));
+    rng.setState(rngState);
+    
+    uint32_t blockedCount = in.getU32();
+    if (blockedCount > static_cast<uint64_t>(mapWidth) * mapHeight) {
+        throw runtime_error("Corrupt snapshot file");
+    }
+    blockedPositions.resize(blockedCount);
+    for (auto& pos : blockedPositions) {
+        pos.first = in.getI32();
+        pos.second = in.getI32();
+    }
+    
+    frontier.clear();
+    uint64_t frontierCount = in.getU64();
+    if (frontierCount > static_cast<uint64_t>(mapWidth) * mapHeight) {
+        throw runtime_error("Corrupt snapshot file");
+    }
+    frontier.reserve(frontierCount);
+    for (uint64_t i = 0; i < frontierCount; i++) {
+        frontier.insert(static_cast<long long>(in.getU64()));
+    }
+    
+    knownMinX = in.getI32();
+    knownMinY = in.getI32();
+    knownMaxX = in.getI32();
+    knownMaxY = in.getI32();
+    memory.load(in);
+    visionX = -1;
 }
\ No newline at end of file
@@ -2,9 +2,18 @@
 #define HERO_H
 #include <vector>
 #include <set>
+#include <unordered_set>
 #include <string>
+#include <cstdint>
+#include "Rng.h"
+#include "Pathfinder.h"
+#include "HeroMemory.h"
+#include "VisionTable.h"
+#include "TeamMap.h"
 
 class Maze;
+class SnapshotWriter;
+class SnapshotReader;
 
 class Hero {
 private:
@@ -15,20 +24,42 @@ private:
     bool isTrapped;
     
     // Memory system
-    std::vector<std::vector<bool>> visited;
-    std::vector<std::vector<char>> knownMap;
+    HeroMemory memory;
     int mapWidth, mapHeight; 
     std::pair<int, int> lastMove;
     std::pair<int, int> previousPosition;
     int stuckCounter;  // Counter for stucks
+    Rng rng;
+    Pathfinder pathfinder;
 
     std::vector<std::pair<int, int>> blockedPositions;
     
-    std::vector<std::pair<int, int>> getValidMoves(const Maze* maze) const;
+    // Known open cells next to at least one unknown cell, keyed by
+    // y * mapWidth + x. Kept up to date by updateVision.
+    std::unordered_set<long long> frontier;
+    int knownMinX, knownMinY, knownMaxX, knownMaxY;
+    
+    // Field of view, see VisionTable. With line of sight visibleCells
+    // holds the result of the last updateVision (0 hidden, 1 seen wall,
+    // 2 seen open) for the window around visionX, visionY.
+    const VisionTable* vision;
+    bool lineOfSight;
+    int visionX, visionY;
+    std::vector<uint8_t> visibleCells;
+    
+    void computeLineOfSight(const Maze* maze);
+    
+    // Shared with the other heroes, nullptr when the hero explores alone
+    TeamMap* team;
+    bool isFrontierCell(int cellX, int cellY) const;
+    void refreshFrontier(int cellX, int cellY);
+    std::pair<int, int> moveTowardsFrontier();
+    
     std::pair<int, int> exploreUnknown(const Maze* maze);
     std::pair<int, int> exploreUnknownSmart(const Maze* maze);
     std::pair<int, int> exploreUnknownSmartWithBlocked(const Maze* maze);
     std::pair<int, int> moveTowardsTarget(int targetX, int targetY, const Maze* maze);
+    std::pair<int, int> greedyMoveTowardsTarget(int targetX, int targetY, const Maze* maze);
     std::pair<int, int> randomValidMove(const Maze* maze);
     std::pair<int, int> smartRandomMove(const Maze* maze);
     std::pair<int, int> smartRandomMoveWithBlocked(const Maze* maze);
@@ -39,7 +70,8 @@ private:
     bool isBlockedPosition(int x, int y) const;
     
 public:
-    Hero(int startX, int startY, char sym, const std::string& heroName, int mWidth, int mHeight);
+    Hero(int startX, int startY, char sym, const std::string& heroName, int mWidth, int mHeight,
+         uint64_t seed);
     ~Hero();
     
     // Position and state
@@ -54,11 +86,24 @@ public:
     void setHasKey(bool key);
     void setTrapped(bool trapped) { isTrapped = trapped; }
     
+    // Radius 1 without line of sight is the 3x3 square around the hero
+    void setVision(int radius, bool useLineOfSight);
+    int getVisionRadius() const { return vision->getRadius(); }
+    bool hasLineOfSight() const { return lineOfSight; }
+    
+    // With a team map updateVision also publishes what the hero saw, and
+    // syncTeamMap takes over what the others published since the journal
+    // was last cleared
+    void setTeamMap(TeamMap* teamMap) { team = teamMap; }
+    void syncTeamMap();
+    
     // Memory management
     void updateVision(const Maze* maze);
     void markVisited(int posX, int posY);
     bool hasVisited(int posX, int posY) const;
     char getKnownCell(int posX, int posY) const;
+    size_t getFrontierSize() const { return frontier.size(); }
+    const HeroMemory& getMemory() const { return memory; }
 
     void notifyBlockedMove(int blockedX, int blockedY);
     void clearBlockedPositions(); 
@@ -66,6 +111,12 @@ public:
     std::pair<int, int> decideNextMove(const Maze* maze, int keyX = -1, int keyY = -1, 
                                        const std::vector<std::pair<int, int>>& visibleCages = {});
     
+    std::vector<std::pair<int, int>> getValidMoves(const Maze* maze) const;
+    
+    // Everything the hero remembers, for Game snapshots
+    void saveState(SnapshotWriter& out) const;
+    void loadState(SnapshotReader& in);
+    
     bool isAdjacent(int otherX, int otherY) const;
     bool canSeePosition(int targetX, int targetY) const;
 };
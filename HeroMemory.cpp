@@ -0,0 +1,145 @@
+#include "HeroMemory.h"
+#include "SnapshotStream.h"
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+HeroMemory::HeroMemory(int mapWidth, int mapHeight) 
+    : width(mapWidth), height(mapHeight), allocatedTiles(0) {
+    
+    tilesPerRow = (width + TILE_SIZE - 1) >> TILE_SHIFT;
+    int tileRows = (height + TILE_SIZE - 1) >> TILE_SHIFT;
+    tiles.resize(static_cast<size_t>(tilesPerRow) * tileRows);
+}
+
+HeroMemory::HeroMemory(const HeroMemory& other) 
+    : width(0), height(0), tilesPerRow(0), allocatedTiles(0) {
+    *this = other;
+}
+
+HeroMemory& HeroMemory::operator=(const HeroMemory& other) {
+    if (this == &other) {
+        return *this;
+    }
+    width = other.width;
+    height = other.height;
+    tilesPerRow = other.tilesPerRow;
+    allocatedTiles = other.allocatedTiles;
+    tiles.clear();
+    tiles.resize(other.tiles.size());
+    for (size_t i = 0; i < tiles.size(); i++) {
+        if (other.tiles[i]) {
+            tiles[i].reset(new Tile(*other.tiles[i]));
+        }
+    }
+    return *this;
+}
+
+HeroMemory::Tile* HeroMemory::getOrCreateTile(int x, int y) {
+    unique_ptr<Tile>& tile = tiles[tileIndex(x, y)];
+    if (!tile) {
+        tile.reset(new Tile);
+        memset(tile.get(), 0, sizeof(Tile)); // All unknown, nothing visited
+        allocatedTiles++;
+    }
+    return tile.get();
+}
+
+bool HeroMemory::setCode(int x, int y, int code) {
+    if (x < 0 || x >= width || y < 0 || y >= height) {
+        return false;
+    }
+    if (getCode(x, y) == code) {
+        return false;
+    }
+    
+    Tile* tile = getOrCreateTile(x, y);
+    int bit = ((y & TILE_MASK) * TILE_SIZE + (x & TILE_MASK)) * 2;
+    uint64_t& word = tile->cells[bit >> 6];
+    word = (word & ~(3ULL << (bit & 63))) | (static_cast<uint64_t>(code) << (bit & 63));
+    return true;
+}
+
+uint64_t HeroMemory::mergeRow(int y, int x0, int x1, uint64_t wallBits, uint64_t columnMask) {
+    if (y < 0 || y >= height || x0 < 0 || x1 >= width || x0 > x1 || x1 - x0 >= 64) {
+        return 0;
+    }
+    
+    int count = x1 - x0 + 1;
+    if (count < 64) {
+        columnMask &= (1ULL << count) - 1;
+    }
+    
+    // A tile row holds 64 cells in two words of 32 two-bit codes
+    uint64_t changed = 0;
+    int x = x0;
+    while (x <= x1) {
+        int last = min(x1, x | 31);
+        int offset = x - x0;
+        int cells = last - x + 1;
+        uint32_t cellMask = static_cast<uint32_t>(columnMask >> offset) & (cells == 32 ? ~0U : (1U << cells) - 1);
+        if (cellMask) {
+            Tile* tile = getOrCreateTile(x, y);
+            uint64_t& word = tile->cells[(y & TILE_MASK) * 2 + ((x & TILE_MASK) >> 5)];
+            int shift = (x & 31) * 2;
+            
+            // OPEN is 01 and WALL is 10
+            uint32_t walls = static_cast<uint32_t>(wallBits >> offset);
+            uint64_t codes = (spreadBits(~walls & cellMask) | (spreadBits(walls & cellMask) << 1)) << shift;
+            uint64_t mask = (spreadBits(cellMask) * 3) << shift;
+            uint64_t updated = (word & ~mask) | codes;
+            uint64_t diff = word ^ updated;
+            word = updated;
+            
+            uint64_t changedCells = compactBits((diff | (diff >> 1)) >> shift);
+            changed |= changedCells << offset;
+        }
+        x = last + 1;
+    }
+    return changed;
+}
+
+void HeroMemory::markVisited(int x, int y) {
+    if (x < 0 || x >= width || y < 0 || y >= height) {
+        return;
+    }
+    Tile* tile = getOrCreateTile(x, y);
+    tile->visited[y & TILE_MASK] |= 1ULL << (x & TILE_MASK);
+}
+
+size_t HeroMemory::getMemoryBytes() const {
+    return sizeof(HeroMemory) + tiles.size() * sizeof(tiles[0]) + allocatedTiles * sizeof(Tile);
+}
+
+
+void HeroMemory::save(SnapshotWriter& out) const {
+    out.putU64(allocatedTiles);
+    for (size_t i = 0; i < tiles.size(); i++) {
+        if (tiles[i]) {
+            out.putU64(i);
+            out.putBytes(tiles[i].get(), sizeof(Tile));
+        }
+    }
+}
+
+void HeroMemory::load(SnapshotReader& in) {
+    for (auto& tile : tiles) {
+        tile.reset();
+    }
+    
+    uint64_t count = in.getU64();
+    if (count > tiles.size()) {
+        throw runtime_error("Corrupt snapshot file");
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t index = in.getU64();
+        if (index >= tiles.size() || tiles[index]) {
+            throw runtime_error("Corrupt snapshot file");
+        }
+        tiles[index].reset(new Tile);
+        in.getBytes(tiles[index].get(), sizeof(Tile));
+    }
+    allocatedTiles = count;
+}
\ No newline at end of file
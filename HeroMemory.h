@@ -0,0 +1,120 @@
+#ifndef HEROMEMORY_H
+#define HEROMEMORY_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+// What a hero remembers about the map: a 2-bit code per cell (unknown,
+// open, wall) and a visited flag. Storage is split into 64x64 tiles that
+// are only allocated when the hero first sees something inside them, so
+// memory grows with the explored area instead of the map size.
+class HeroMemory {
+public:
+    enum CellCode {
+        UNKNOWN = 0,
+        OPEN = 1,
+        WALL = 2
+    };
+    
+    static const int TILE_SHIFT = 6;
+    static const int TILE_SIZE = 1 << TILE_SHIFT;
+    static const int TILE_MASK = TILE_SIZE - 1;
+    
+    HeroMemory(int mapWidth, int mapHeight);
+    
+    HeroMemory(const HeroMemory& other);
+    HeroMemory& operator=(const HeroMemory& other);
+    
+    // Out of bounds cells read as WALL, unallocated tiles as UNKNOWN
+    int getCode(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) {
+            return WALL;
+        }
+        const Tile* tile = tiles[tileIndex(x, y)].get();
+        if (!tile) {
+            return UNKNOWN;
+        }
+        int bit = ((y & TILE_MASK) * TILE_SIZE + (x & TILE_MASK)) * 2;
+        return (tile->cells[bit >> 6] >> (bit & 63)) & 3;
+    }
+    
+    // '?', ' ' or '*', the symbols used by Hero::getKnownCell
+    char getCell(int x, int y) const {
+        static const char symbols[] = {'?', ' ', '*', '*'};
+        return symbols[getCode(x, y)];
+    }
+    
+    // Returns true when the stored code changed
+    bool setCode(int x, int y, int code);
+    
+    // Stores columns x0..x1 of row y (at most 64) as open or wall, bit i of
+    // wallBits and columnMask is column x0 + i. Only the columns set in
+    // columnMask are written. Returns the columns whose code changed, in
+    // the same bit layout. Works on whole words.
+    uint64_t mergeRow(int y, int x0, int x1, uint64_t wallBits, uint64_t columnMask = ~0ULL);
+    
+    // Bit i of value moves to bit 2i, i.e. one bit per cell to one code
+    static uint64_t spreadBits(uint32_t value) {
+        uint64_t bits = value;
+        bits = (bits | (bits << 16)) & 0x0000FFFF0000FFFFULL;
+        bits = (bits | (bits << 8)) & 0x00FF00FF00FF00FFULL;
+        bits = (bits | (bits << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        bits = (bits | (bits << 2)) & 0x3333333333333333ULL;
+        bits = (bits | (bits << 1)) & 0x5555555555555555ULL;
+        return bits;
+    }
+    
+    // The reverse: bit 2i moves to bit i, odd bits are ignored
+    static uint32_t compactBits(uint64_t bits) {
+        bits &= 0x5555555555555555ULL;
+        bits = (bits | (bits >> 1)) & 0x3333333333333333ULL;
+        bits = (bits | (bits >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+        bits = (bits | (bits >> 4)) & 0x00FF00FF00FF00FFULL;
+        bits = (bits | (bits >> 8)) & 0x0000FFFF0000FFFFULL;
+        bits = (bits | (bits >> 16)) & 0x00000000FFFFFFFFULL;
+        return static_cast<uint32_t>(bits);
+    }
+    
+    bool isVisited(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) {
+            return false;
+        }
+        const Tile* tile = tiles[tileIndex(x, y)].get();
+        return tile && ((tile->visited[y & TILE_MASK] >> (x & TILE_MASK)) & 1);
+    }
+    
+    void markVisited(int x, int y);
+    
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    size_t getAllocatedTiles() const { return allocatedTiles; }
+    size_t getMemoryBytes() const;
+    
+    // Snapshots store the allocated tiles as raw bytes
+    void save(SnapshotWriter& out) const;
+    void load(SnapshotReader& in);
+    
+private:
+    struct Tile {
+        uint64_t cells[TILE_SIZE * TILE_SIZE * 2 / 64];
+        uint64_t visited[TILE_SIZE];
+    };
+    
+    int width, height;
+    int tilesPerRow;
+    size_t allocatedTiles;
+    std::vector<std::unique_ptr<Tile>> tiles;
+    
+    size_t tileIndex(int x, int y) const {
+        return static_cast<size_t>(y >> TILE_SHIFT) * tilesPerRow + (x >> TILE_SHIFT);
+    }
+    
+    Tile* getOrCreateTile(int x, int y);
+};
+
+#endif
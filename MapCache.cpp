@@ -0,0 +1,150 @@
+#include "MapCache.h"
+#include "MazeFormat.h"
+#include "MappedFile.h"
+#include "DistanceOracle.h"
+#include "Rng.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+MapCache::MapCache(const string& cacheDirectory) : directory(cacheDirectory), lastLoadHit(false) {
+    if (directory.empty()) {
+        directory = defaultDirectory();
+    }
+}
+
+string MapCache::defaultDirectory() {
+    const char* configured = getenv("MAZE_CACHE_DIR");
+    if (configured && *configured) {
+        return configured;
+    }
+    const char* xdgCache = getenv("XDG_CACHE_HOME");
+    if (xdgCache && *xdgCache) {
+        return string(xdgCache) + "/maze_game";
+    }
+    const char* home = getenv("HOME");
+    if (home && *home) {
+        return string(home) + "/.cache/maze_game";
+    }
+    return ".maze_cache";
+}
+
+uint64_t MapCache::hashFile(const string& filename) {
+    MappedFile file(filename);
+    const char* data = file.getData();
+    size_t size = file.getSize();
+    
+    uint64_t hash = Rng::mix(size);
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = Rng::mix(hash ^ word) + i;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, size - i);
+    return Rng::mix(hash ^ tail);
+}
+
+string MapCache::getEntryPath(uint64_t sourceHash) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.mzb", static_cast<unsigned long long>(sourceHash));
+    return directory + "/" + name;
+}
+
+string MapCache::preprocess(const Maze& maze, int landmarkCount, uint64_t sourceHash) {
+    // The heroes walk to the ladder once every inner wall is gone
+    Maze dissolved(maze);
+    dissolved.clearWalls(1, 1, maze.getWidth() - 2, maze.getHeight() - 2);
+    
+    vector<string> sections(2);
+    DistanceOracle(maze, landmarkCount).appendSection(sections[0]);
+    DistanceOracle(dissolved, 0).appendSection(sections[1]);
+    
+    PrecomputedHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PRECOMPUTED_MAGIC, sizeof(header.magic));
+    header.version = PRECOMPUTED_VERSION;
+    header.sourceHash = sourceHash;
+    header.sectionCount = sections.size();
+    
+    string data(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t offset = sizeof(header) + sections.size() * sizeof(PrecomputedSection);
+    for (const string& section : sections) {
+        PrecomputedSection entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.kind = PRECOMPUTED_DISTANCE_ORACLE;
+        entry.offset = offset;
+        entry.bytes = section.size();
+        data.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        offset += (section.size() + 7) & ~static_cast<uint64_t>(7);
+    }
+    for (const string& section : sections) {
+        data += section;
+        data.resize((data.size() + 7) & ~static_cast<size_t>(7), 0);
+    }
+    return data;
+}
+
+bool MapCache::isUsable(const Maze& cached, uint64_t sourceHash, int landmarkCount) {
+    PrecomputedHeader header;
+    if (cached.getPrecomputedSize() < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, cached.getPrecomputedData(), sizeof(header));
+    return header.sourceHash == sourceHash &&
+           DistanceOracle::findPrecomputed(cached, cached.getContentHash(), landmarkCount) != nullptr;
+}
+
+void MapCache::makeDirectory() const {
+    // Every missing parent too, like mkdir -p
+    for (size_t slash = directory.find('/', 1); ; slash = directory.find('/', slash + 1)) {
+        string path = directory.substr(0, slash);
+        if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw runtime_error("Cannot create cache directory " + path + ": " + strerror(errno));
+        }
+        if (slash == string::npos) {
+            break;
+        }
+    }
+}
+
+Maze MapCache::load(const string& mapFile, int landmarkCount) {
+    uint64_t sourceHash = hashFile(mapFile);
+    string entryPath = getEntryPath(sourceHash);
+    
+    lastLoadHit = false;
+    if (access(entryPath.c_str(), R_OK) == 0) {
+        try {
+            Maze cached(entryPath);
+            if (isUsable(cached, sourceHash, landmarkCount)) {
+                lastLoadHit = true;
+                return cached;
+            }
+        } catch (const exception&) {
+            // Unreadable entry, it is made again below
+        }
+    }
+    
+    Maze maze(mapFile);
+    try {
+        makeDirectory();
+        string temporary = entryPath + ".tmp" + to_string(getpid());
+        maze.saveCompiled(temporary, preprocess(maze, landmarkCount, sourceHash));
+        if (rename(temporary.c_str(), entryPath.c_str()) != 0) {
+            remove(temporary.c_str());
+            return maze;
+        }
+        // Map the new entry, so this run uses the data without building it again
+        return Maze(entryPath);
+    } catch (const exception&) {
+        // A read-only cache only costs the preprocessing
+        return maze;
+    }
+}
\ No newline at end of file
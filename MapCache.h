@@ -0,0 +1,46 @@
+#ifndef MAPCACHE_H
+#define MAPCACHE_H
+
+#include <string>
+#include <cstdint>
+#include "Maze.h"
+
+// Local cache of preprocessed maps. Every map is stored once as a compiled
+// maze (see MazeFormat.h) named after the hash of the source file bytes,
+// with the precomputed data in its data section: distance oracles for the
+// map as loaded and for the map after the walls dissolve. A cached map is
+// memory mapped, so later runs and every game in them share one copy.
+//
+// Entries are checked on every load; a changed map file hashes to a new
+// entry, and entries that are corrupt, from another format version or with
+// too few landmarks are simply built again. Writes go to a temporary file
+// that is renamed, so concurrent runs never see half an entry.
+class MapCache {
+public:
+    explicit MapCache(const std::string& cacheDirectory);
+    
+    // $MAZE_CACHE_DIR, else $XDG_CACHE_HOME/maze_game, else ~/.cache/maze_game
+    static std::string defaultDirectory();
+    
+    // The map in mapFile with at least landmarkCount landmarks precomputed.
+    // If the cache can't be written the map is still returned, just without
+    // precomputed data.
+    Maze load(const std::string& mapFile, int landmarkCount);
+    
+    // Precomputed data section for a maze, as stored in the cache and by maze_compile
+    static std::string preprocess(const Maze& maze, int landmarkCount, uint64_t sourceHash);
+    
+    static uint64_t hashFile(const std::string& filename);
+    
+    std::string getEntryPath(uint64_t sourceHash) const;
+    bool wasLastLoadHit() const { return lastLoadHit; }
+    
+private:
+    std::string directory;
+    bool lastLoadHit;
+    
+    static bool isUsable(const Maze& cached, uint64_t sourceHash, int landmarkCount);
+    void makeDirectory() const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef MAPHASHCACHE_H
+#define MAPHASHCACHE_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// The last few values built for a map, found by the map's content hash.
+// Games on one map follow each other closely, so a handful of entries is
+// enough. Thread-safe; values are built under the lock, so threads asking
+// for the same map wait for one build.
+template <typename T, size_t Capacity = 4>
+class MapHashCache {
+public:
+    // A cached value for mapHash that matches(value) accepts, else the one
+    // build() returns, which then replaces the least recently used entry
+    template <typename Matches, typename Build>
+    std::shared_ptr<const T> get(uint64_t mapHash, const Matches& matches, const Build& build) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i].mapHash == mapHash && matches(*entries[i].value)) {
+                Entry found = entries[i];
+                entries.erase(entries.begin() + i);
+                entries.push_back(found);
+                return found.value;
+            }
+        }
+        
+        std::shared_ptr<const T> built = build();
+        if (entries.size() >= Capacity) {
+            entries.erase(entries.begin());
+        }
+        entries.push_back({mapHash, built});
+        return built;
+    }
+    
+private:
+    struct Entry {
+        uint64_t mapHash;
+        std::shared_ptr<const T> value;
+    };
+    
+    std::mutex cacheMutex;
+    std::vector<Entry> entries;   // most recently used last
+};
+
+#endif
\ No newline at end of file
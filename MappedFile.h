@@ -0,0 +1,25 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. The mapping is shared with
+// every other process that maps the same file.
+class MappedFile {
+public:
+    MappedFile(const std::string& filename);
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    const char* getData() const { return data; }
+    size_t getSize() const { return size; }
+    
+private:
+    const char* data;
+    size_t size;
+};
+
+#endif
@@ -1,42 +1,128 @@
 #include "Maze.h"
+#include "MazeFormat.h"
+#include "MappedFile.h"
+#include "Rng.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include <fstream>
+#include <sstream>
 #include <iostream>
+#include <stdexcept>
 #include <ncurses.h>
 
 using namespace std;
 
-Maze::Maze(const string& filename) : width(0), height(0), ladderX(-1), ladderY(-1) {
-    ifstream file(filename);
+Maze::Maze(const string& filename) 
+    : wallWords(nullptr), precomputedData(nullptr), precomputedBytes(0),
+      width(0), height(0), rowWords(0), ladderX(-1), ladderY(-1), wallCount(0) {
+    
+    // Compiled files start with a magic number, anything else is text
+    char magic[4] = {0, 0, 0, 0};
+    ifstream probe(filename, ios::binary);
+    if (!probe.is_open()) {
+        throw runtime_error("Cannot open maze file: " + filename);
+    }
+    probe.read(magic, sizeof(magic));
+    probe.close();
+    
+    if (memcmp(magic, COMPILED_MAZE_MAGIC, sizeof(magic)) == 0) {
+        loadCompiled(filename);
+    } else {
+        loadText(filename);
+    }
+}
+
+Maze::Maze(int mazeWidth, int mazeHeight) 
+    : wallWords(nullptr), precomputedData(nullptr), precomputedBytes(0),
+      width(0), height(0), rowWords(0), ladderX(-1), ladderY(-1), wallCount(0) {
+    
+    if (mazeWidth <= 0 || mazeHeight <= 0) {
+        throw runtime_error("Maze dimensions must be positive");
+    }
+    allocateGrid(mazeWidth, mazeHeight);
+}
+
+Maze::Maze(const Maze& other) 
+    : wallWords(nullptr), precomputedData(nullptr), precomputedBytes(0),
+      width(0), height(0), rowWords(0), ladderX(-1), ladderY(-1), wallCount(0) {
+    *this = other;
+}
+
+Maze& Maze::operator=(const Maze& other) {
+    if (this == &other) {
+        return *this;
+    }
+    walls = other.walls;
+    mapping = other.mapping;
+    wallWords = other.isMapped() ? other.wallWords : walls.data();
+    precomputedData = other.precomputedData;
+    precomputedBytes = other.precomputedBytes;
+    width = other.width;
+    height = other.height;
+    rowWords = other.rowWords;
+    ladderX = other.ladderX;
+    ladderY = other.ladderY;
+    rowWallCounts = other.rowWallCounts;
+    wallCount = other.wallCount;
+    return *this;
+}
+
+void Maze::loadText(const string& filename) {
+    ifstream file(filename, ios::binary);
     if (!file.is_open()) {
         throw runtime_error("Cannot open maze file: " + filename);
     }
     
-    string line;
-    vector<string> tempGrid;
+    // Read the whole file at once
+    stringstream buffer;
+    buffer << file.rdbuf();
+    string text = buffer.str();
+    file.close();
     
-    // Read all lines
-    while (getline(file, line)) {
-        tempGrid.push_back(line);
-        if (line.length() > width) {
-            width = line.length();
+    // First pass: dimensions. Lines may end with \r\n
+    size_t lineStart = 0;
+    while (lineStart < text.size()) {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == string::npos) {
+            lineEnd = text.size();
+        }
+        size_t length = lineEnd - lineStart;
+        if (length > 0 && text[lineEnd - 1] == '\r') {
+            length--;
+        }
+        if (static_cast<int>(length) > width) {
+            width = length;
         }
+        height++;
+        lineStart = lineEnd + 1;
     }
-    file.close();
     
-    height = tempGrid.size();
-    
-    // Initialize grid and find ladder
-    grid.resize(height);
-    for (int i = 0; i < height; i++) {
-        grid[i].resize(width, '*'); 
-        for (int j = 0; j < tempGrid[i].length(); j++) {
-            grid[i][j] = tempGrid[i][j];
-            if (tempGrid[i][j] == 'L') {
-                ladderX = j;
-                ladderY = i;
-                grid[i][j] = ' '; // Convert L to space for movement
+    // Short lines are padded with walls
+    allocateGrid(width, height);
+    
+    // Second pass: open cells and ladder
+    lineStart = 0;
+    for (int y = 0; y < height; y++) {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == string::npos) {
+            lineEnd = text.size();
+        }
+        for (size_t i = lineStart; i < lineEnd; i++) {
+            char cell = text[i];
+            if (cell == '\r') {
+                break;
+            }
+            int x = i - lineStart;
+            if (cell == 'L') {
+                ladderX = x;
+                ladderY = y; // L is open space for movement
+            }
+            if (cell != '*') {
+                setWallBit(x, y, false);
             }
         }
+        lineStart = lineEnd + 1;
     }
     
     if (ladderX == -1 || ladderY == -1) {
@@ -44,25 +130,257 @@ Maze::Maze(const string& filename) : width(0), height(0), ladderX(-1), ladderY(-
     }
 }
 
+void Maze::loadCompiled(const string& filename) {
+    mapping = make_shared<MappedFile>(filename);
+    const char* data = mapping->getData();
+    size_t size = mapping->getSize();
+    
+    CompiledMazeHeader header;
+    if (size < sizeof(header)) {
+        throw runtime_error("Truncated compiled maze: " + filename);
+    }
+    memcpy(&header, data, sizeof(header));
+    
+    if (header.version != COMPILED_MAZE_VERSION) {
+        throw runtime_error("Unsupported compiled maze version in " + filename);
+    }
+    
+    // The padded sizes and the cell counts must fit an int
+    if (header.width < 1 || header.height < 1 || header.width > INT_MAX - 2 || header.height > INT_MAX - 2 ||
+        static_cast<uint64_t>(header.width) * header.height > INT_MAX) {
+        throw runtime_error("Corrupt compiled maze: " + filename);
+    }
+    width = header.width;
+    height = header.height;
+    rowWords = static_cast<int>((static_cast<size_t>(width) + 2 + 63) / 64);
+    ladderX = header.ladderX;
+    ladderY = header.ladderY;
+    
+    uint64_t expectedBytes = static_cast<uint64_t>(height + 2) * rowWords * sizeof(uint64_t);
+    if (header.rowWords != static_cast<uint32_t>(rowWords) || header.wallsBytes != expectedBytes ||
+        header.wallsOffset % sizeof(uint64_t) != 0 || header.wallsOffset > size || 
+        header.wallsBytes > size - header.wallsOffset ||
+        header.dataOffset % sizeof(uint64_t) != 0 || header.dataOffset > size || 
+        header.dataBytes > size - header.dataOffset) {
+        throw runtime_error("Corrupt compiled maze: " + filename);
+    }
+    if (!isValidPosition(ladderX, ladderY)) {
+        throw runtime_error("No ladder found in maze file");
+    }
+    
+    // Zero-copy: read walls straight from the mapping
+    walls.clear();
+    wallWords = reinterpret_cast<const uint64_t*>(data + header.wallsOffset);
+    
+    // Every scan relies on the border and padding bits being walls, so a
+    // file without them is rejected rather than walked off its rows
+    const uint64_t* firstRow = wallWords;
+    const uint64_t* lastRow = wallWords + static_cast<size_t>(height + 1) * rowWords;
+    for (int word = 0; word < rowWords; word++) {
+        if (firstRow[word] != ~0ULL || lastRow[word] != ~0ULL) {
+            throw runtime_error("Corrupt compiled maze: " + filename);
+        }
+    }
+    size_t borderBit = static_cast<size_t>(width) + 1;
+    uint64_t paddingMask = ~0ULL << (borderBit & 63);
+    for (int y = 0; y < height; y++) {
+        const uint64_t* row = getWallRow(y);
+        if (!(row[0] & 1) || (row[borderBit >> 6] & paddingMask) != paddingMask) {
+            throw runtime_error("Corrupt compiled maze: " + filename);
+        }
+        for (int word = static_cast<int>(borderBit >> 6) + 1; word < rowWords; word++) {
+            if (row[word] != ~0ULL) {
+                throw runtime_error("Corrupt compiled maze: " + filename);
+            }
+        }
+    }
+    if (header.dataBytes > 0) {
+        precomputedData = data + header.dataOffset;
+        precomputedBytes = header.dataBytes;
+    }
+    countAllWalls();
+}
+
+vector<pair<const char*, size_t>> Maze::getPrecomputedSections(uint32_t kind) const {
+    vector<pair<const char*, size_t>> sections;
+    PrecomputedHeader header;
+    if (precomputedBytes < sizeof(header)) {
+        return sections;
+    }
+    memcpy(&header, precomputedData, sizeof(header));
+    if (memcmp(header.magic, PRECOMPUTED_MAGIC, sizeof(header.magic)) != 0 || 
+        header.version != PRECOMPUTED_VERSION ||
+        header.sectionCount > (precomputedBytes - sizeof(header)) / sizeof(PrecomputedSection)) {
+        return sections;
+    }
+    
+    for (uint32_t i = 0; i < header.sectionCount; i++) {
+        PrecomputedSection section;
+        memcpy(&section, precomputedData + sizeof(header) + i * sizeof(section), sizeof(section));
+        if (section.offset % sizeof(uint64_t) != 0 || section.offset > precomputedBytes ||
+            section.bytes > precomputedBytes - section.offset) {
+            sections.clear();
+            return sections;  // Corrupt, use none of it
+        }
+        if (section.kind == kind) {
+            sections.push_back({precomputedData + section.offset, section.bytes});
+        }
+    }
+    return sections;
+}
+
+void Maze::saveText(const string& filename) const {
+    ofstream file(filename, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        throw runtime_error("Cannot write maze file: " + filename);
+    }
+    
+    string line;
+    for (int y = 0; y < height; y++) {
+        line.assign(width, ' ');
+        for (int x = 0; x < width; x++) {
+            if (isWallUnchecked(x, y)) {
+                line[x] = '*';
+            }
+        }
+        if (y == ladderY) {
+            line[ladderX] = 'L';
+        }
+        line += '\n';
+        file.write(line.data(), line.size());
+    }
+    if (!file) {
+        throw runtime_error("Cannot write maze file: " + filename);
+    }
+}
+
+void Maze::saveCompiled(const string& filename, const string& data) const {
+    CompiledMazeHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, COMPILED_MAZE_MAGIC, sizeof(header.magic));
+    header.version = COMPILED_MAZE_VERSION;
+    header.width = width;
+    header.height = height;
+    header.ladderX = ladderX;
+    header.ladderY = ladderY;
+    header.rowWords = rowWords;
+    header.wallsOffset = sizeof(header);
+    header.wallsBytes = static_cast<uint64_t>(height + 2) * rowWords * sizeof(uint64_t);
+    if (!data.empty()) {
+        header.dataOffset = header.wallsOffset + header.wallsBytes;
+        header.dataBytes = data.size();
+    }
+    
+    ofstream file(filename, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        throw runtime_error("Cannot write maze file: " + filename);
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(wallWords), header.wallsBytes);
+    file.write(data.data(), data.size());
+    if (!file) {
+        throw runtime_error("Cannot write maze file: " + filename);
+    }
+}
+
 Maze::~Maze() {
     // Vectors automatically clean up
 }
 
-char Maze::getCell(int x, int y) const {
-    if (x < 0 || x >= width || y < 0 || y >= height) {
-        return '*'; // Out of bounds is wall
+void Maze::allocateGrid(int gridWidth, int gridHeight) {
+    width = gridWidth;
+    height = gridHeight;
+    rowWords = (width + 2 + 63) / 64;
+    walls.assign(static_cast<size_t>(height + 2) * rowWords, ~0ULL);
+    wallWords = walls.data();
+    rowWallCounts.assign(height, width);
+    wallCount = width * height;
+}
+
+void Maze::countAllWalls() {
+    rowWallCounts.resize(height);
+    wallCount = 0;
+    for (int y = 0; y < height; y++) {
+        rowWallCounts[y] = countRowWalls(y);
+        wallCount += rowWallCounts[y];
+    }
+}
+
+int Maze::countRowWalls(int y) const {
+    const uint64_t* row = getWallRow(y);
+    int count = 0;
+    for (size_t word = 0; word <= static_cast<size_t>(width) >> 6; word++) {
+        count += __builtin_popcountll(row[word] & rangeMask(word, 1, width));
+    }
+    return count;
+}
+
+void Maze::makeWritable() {
+    if (isMapped()) {
+        // Copy on write, the mapping itself is read-only
+        walls.assign(wallWords, wallWords + static_cast<size_t>(height + 2) * rowWords);
+        wallWords = walls.data();
+    }
+}
+
+void Maze::setWallBit(int x, int y, bool wall) {
+    makeWritable();
+    
+    size_t bit = static_cast<size_t>(x + 1);
+    uint64_t& word = walls[static_cast<size_t>(y + 1) * rowWords + (bit >> 6)];
+    uint64_t mask = 1ULL << (bit & 63);
+    if (((word & mask) != 0) == wall) {
+        return;
+    }
+    if (wall) {
+        word |= mask;
+    } else {
+        word &= ~mask;
+    }
+    int change = wall ? 1 : -1;
+    rowWallCounts[y] += change;
+    wallCount += change;
+}
+
+void Maze::setWallRow(int y, const uint64_t* words) {
+    if (y < 0 || y >= height) {
+        return;
+    }
+    makeWritable();
+    
+    uint64_t* row = walls.data() + static_cast<size_t>(y + 1) * rowWords;
+    for (int i = 0; i < rowWords; i++) {
+        // Padded bits 0 and width + 1 onwards are always wall
+        uint64_t border = 0;
+        int firstBit = i * 64;
+        if (firstBit == 0) {
+            border |= 1;
+        }
+        int lastOpenBit = width; // bit of column width - 1
+        if (lastOpenBit + 1 < firstBit + 64) {
+            int from = max(lastOpenBit + 1 - firstBit, 0);
+            border |= ~0ULL << from;
+        }
+        row[i] = words[i] | border;
     }
-    return grid[y][x];
+    
+    int count = countRowWalls(y);
+    wallCount += count - rowWallCounts[y];
+    rowWallCounts[y] = count;
 }
 
 void Maze::setCell(int x, int y, char value) {
     if (isValidPosition(x, y)) {
-        grid[y][x] = value;
+        setWallBit(x, y, value == '*');
     }
 }
 
-bool Maze::isWall(int x, int y) const {
-    return getCell(x, y) == '*';
+void Maze::setLadder(int x, int y) {
+    if (isValidPosition(x, y)) {
+        ladderX = x;
+        ladderY = y;
+        setWallBit(x, y, false);
+    }
 }
 
 bool Maze::isValidPosition(int x, int y) const {
@@ -71,33 +389,127 @@ bool Maze::isValidPosition(int x, int y) const {
 
 void Maze::removeWall(int x, int y) {
     if (isValidPosition(x, y) && isWall(x, y)) {
-        setCell(x, y, ' ');
+        setWallBit(x, y, false);
     }
 }
 
-vector<pair<int, int>> Maze::getAllWalls() const {
-    vector<pair<int, int>> walls;
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            if (isWall(x, y)) {
-                walls.push_back({x, y});
+uint64_t Maze::getContentHash() const {
+    uint64_t hash = Rng::mix(static_cast<uint64_t>(width) << 32 | static_cast<uint32_t>(height));
+    hash = Rng::mix(hash ^ (static_cast<uint64_t>(ladderX) << 32 | static_cast<uint32_t>(ladderY)));
+    size_t words = static_cast<size_t>(height + 2) * rowWords;
+    for (size_t i = 0; i < words; i++) {
+        hash = Rng::mix(hash ^ wallWords[i]) + i;
+    }
+    return hash;
+}
+
+int Maze::countWalls(int minX, int minY, int maxX, int maxY) const {
+    minX = max(minX, 0);
+    minY = max(minY, 0);
+    maxX = min(maxX, width - 1);
+    maxY = min(maxY, height - 1);
+    if (minX > maxX) {
+        return 0;
+    }
+    
+    size_t firstBit = minX + 1;
+    size_t lastBit = maxX + 1;
+    bool wholeRow = minX == 0 && maxX == width - 1;
+    int count = 0;
+    for (int y = minY; y <= maxY; y++) {
+        if (wholeRow || rowWallCounts[y] == 0) {
+            count += rowWallCounts[y];
+            continue;
+        }
+        const uint64_t* row = getWallRow(y);
+        for (size_t word = firstBit >> 6; word <= lastBit >> 6; word++) {
+            count += __builtin_popcountll(row[word] & rangeMask(word, firstBit, lastBit));
+        }
+    }
+    return count;
+}
+
+int Maze::clearWalls(int minX, int minY, int maxX, int maxY) {
+    minX = max(minX, 0);
+    minY = max(minY, 0);
+    maxX = min(maxX, width - 1);
+    maxY = min(maxY, height - 1);
+    if (minX > maxX || countWalls(minX, minY, maxX, maxY) == 0) {
+        return 0;
+    }
+    makeWritable();
+    
+    size_t firstBit = minX + 1;
+    size_t lastBit = maxX + 1;
+    int removed = 0;
+    for (int y = minY; y <= maxY; y++) {
+        if (rowWallCounts[y] == 0) {
+            continue;
+        }
+        uint64_t* row = walls.data() + static_cast<size_t>(y + 1) * rowWords;
+        int rowRemoved = 0;
+        for (size_t word = firstBit >> 6; word <= lastBit >> 6; word++) {
+            uint64_t mask = rangeMask(word, firstBit, lastBit);
+            rowRemoved += __builtin_popcountll(row[word] & mask);
+            row[word] &= ~mask;
+        }
+        rowWallCounts[y] -= rowRemoved;
+        removed += rowRemoved;
+    }
+    wallCount -= removed;
+    return removed;
+}
+
+bool Maze::findNextWall(int minX, int minY, int maxX, int maxY, int& x, int& y) const {
+    minX = max(minX, 0);
+    minY = max(minY, 0);
+    maxX = min(maxX, width - 1);
+    maxY = min(maxY, height - 1);
+    if (minX > maxX) {
+        return false;
+    }
+    
+    // Start of the search, moved onto the rectangle
+    int startX = x;
+    int startY = y;
+    if (startY < minY) {
+        startY = minY;
+        startX = minX;
+    }
+    if (startX > maxX) {
+        startY++;
+        startX = minX;
+    }
+    startX = max(startX, minX);
+    
+    size_t lastBit = maxX + 1;
+    for (int row = startY; row <= maxY; row++) {
+        if (rowWallCounts[row] > 0) {
+            const uint64_t* words = getWallRow(row);
+            size_t firstBit = (row == startY ? startX : minX) + 1;
+            for (size_t word = firstBit >> 6; word <= lastBit >> 6; word++) {
+                uint64_t bits = words[word] & rangeMask(word, firstBit, lastBit);
+                if (bits) {
+                    x = static_cast<int>(word * 64 + __builtin_ctzll(bits)) - 1;
+                    y = row;
+                    return true;
+                }
             }
         }
     }
-    return walls;
+    return false;
 }
 
 void Maze::display() const {
     for (int y = 0; y < height; y++) {
         for (int x = 0; x < width; x++) {
-            char cell = grid[y][x];
             if (x == ladderX && y == ladderY) {
                 attron(COLOR_PAIR(3)); // Special color for ladder
                 mvaddch(y, x, 'L');
                 attroff(COLOR_PAIR(3));
             } else {
-                mvaddch(y, x, cell);
+                mvaddch(y, x, getCell(x, y));
             }
         }
     }
-}
\ No newline at end of file
+}
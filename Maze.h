@@ -3,32 +3,175 @@
 
 #include <vector>
 #include <string>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+
+class MappedFile;
 
 class Maze {
 private:
-    std::vector<std::vector<char>> grid;
+    // One bit per cell (1 = wall), stored row-major in a single buffer.
+    // The map is surrounded by a one-cell wall border and every padded
+    // row starts on a 64-bit word, so neighbour lookups need no bounds check.
+    // wallWords points either into walls or into a mapped compiled file,
+    // which is copied into walls on the first change.
+    std::vector<uint64_t> walls;
+    const uint64_t* wallWords;
+    std::shared_ptr<MappedFile> mapping;
+    const char* precomputedData;
+    size_t precomputedBytes;
     int width;
     int height;
+    int rowWords;
     int ladderX, ladderY;
     
+    // Wall index: walls per map row and in total, kept up to date by every
+    // change so empty rows can be skipped without looking at their bits
+    std::vector<int> rowWallCounts;
+    int wallCount;
+    
+    void allocateGrid(int gridWidth, int gridHeight);
+    void setWallBit(int x, int y, bool wall);
+    void makeWritable();
+    void countAllWalls();
+    int countRowWalls(int y) const;
+    
+    // Bits firstBit..lastBit of a padded row that fall into the given word
+    static uint64_t rangeMask(size_t word, size_t firstBit, size_t lastBit) {
+        uint64_t mask = ~0ULL;
+        if (word == firstBit >> 6) {
+            mask &= ~0ULL << (firstBit & 63);
+        }
+        if (word == lastBit >> 6) {
+            mask &= ~0ULL >> (63 - (lastBit & 63));
+        }
+        return mask;
+    }
+    void loadText(const std::string& filename);
+    void loadCompiled(const std::string& filename);
+    
 public:
+    // Reads either a text map or a compiled .mzb file
     Maze(const std::string& filename);
+    // All walls and no ladder yet, used by MazeGenerator
+    Maze(int mazeWidth, int mazeHeight);
+    Maze(const Maze& other);
+    Maze& operator=(const Maze& other);
     ~Maze();
     
-    char getCell(int x, int y) const;
+    // Writes the text format read by the constructor
+    void saveText(const std::string& filename) const;
+    // Writes the compiled binary format, see MazeFormat.h
+    void saveCompiled(const std::string& filename, const std::string& data = std::string()) const;
+    
+    // Optional data section of a compiled file, empty for text maps
+    const char* getPrecomputedData() const { return precomputedData; }
+    size_t getPrecomputedSize() const { return precomputedBytes; }
+    bool isMapped() const { return wallWords != walls.data(); }
+    // Keeps the compiled file mapped, for data that points into it
+    std::shared_ptr<const MappedFile> getMapping() const { return mapping; }
+    
+    // The sections of this kind in the precomputed data, as (data, bytes).
+    // Empty when there is no valid precomputed data, see MazeFormat.h.
+    std::vector<std::pair<const char*, size_t>> getPrecomputedSections(uint32_t kind) const;
+    
+    char getCell(int x, int y) const { return isWall(x, y) ? '*' : ' '; }
     void setCell(int x, int y, char value);
-    bool isWall(int x, int y) const;
     bool isValidPosition(int x, int y) const;
     
+    // Anything outside the map counts as wall
+    bool isWall(int x, int y) const {
+        unsigned px = static_cast<unsigned>(x + 1);
+        unsigned py = static_cast<unsigned>(y + 1);
+        if (px > static_cast<unsigned>(width + 1) || py > static_cast<unsigned>(height + 1)) {
+            return true;
+        }
+        return isWallUnchecked(x, y);
+    }
+    
+    // Only valid for -1 <= x <= width and -1 <= y <= height,
+    // i.e. a cell of the map or one of its direct neighbours
+    bool isWallUnchecked(int x, int y) const {
+        size_t bit = static_cast<size_t>(x + 1);
+        const uint64_t word = wallWords[static_cast<size_t>(y + 1) * rowWords + (bit >> 6)];
+        return (word >> (bit & 63)) & 1;
+    }
+    
+    // Raw access to one padded row of wall words: bit x + 1 is column x.
+    // setWallRow keeps the border and padding bits set.
+    int getRowWords() const { return rowWords; }
+    const uint64_t* getWallRow(int y) const { return wallWords + static_cast<size_t>(y + 1) * rowWords; }
+    void setWallRow(int y, const uint64_t* words);
+    
+    // count <= 64 cells of row y starting at column x, bit i is column x + i.
+    // Same range as isWallUnchecked.
+    uint64_t getWallBits(int x, int y, int count) const {
+        const uint64_t* row = getWallRow(y);
+        size_t first = static_cast<size_t>(x + 1);
+        int shift = first & 63;
+        uint64_t bits = row[first >> 6] >> shift;
+        if (shift > 0 && shift + count > 64) {
+            bits |= row[(first >> 6) + 1] << (64 - shift);
+        }
+        return count == 64 ? bits : bits & ((1ULL << count) - 1);
+    }
+    
     int getWidth() const { return width; }
     int getHeight() const { return height; }
     int getLadderX() const { return ladderX; }
     int getLadderY() const { return ladderY; }
+    void setLadder(int x, int y);
     
     void removeWall(int x, int y);
-    std::vector<std::pair<int, int>> getAllWalls() const;
+    
+    // Walls inside the map, the border around it does not count
+    int getWallCount() const { return wallCount; }
+    int getRowWallCount(int y) const { return rowWallCounts[y]; }
+    
+    // The functions below work on the rectangle [minX, maxX] x [minY, maxY],
+    // clipped to the map, one 64-bit word at a time
+    int countWalls(int minX, int minY, int maxX, int maxY) const;
+    // Removes every wall in the rectangle and returns how many there were
+    int clearWalls(int minX, int minY, int maxX, int maxY);
+    // First wall at or after (x, y) in row-major order, false if there is none
+    bool findNextWall(int minX, int minY, int maxX, int maxY, int& x, int& y) const;
+    // Calls visit(x, y) for every wall in row-major order, without copying
+    template <typename Visit>
+    void forEachWall(int minX, int minY, int maxX, int maxY, Visit visit) const;
+    
+    // Hash of the size, ladder and walls, equal for equal mazes however they were loaded
+    uint64_t getContentHash() const;
     
     void display() const;
 };
 
-#endif 
\ No newline at end of file
+template <typename Visit>
+void Maze::forEachWall(int minX, int minY, int maxX, int maxY, Visit visit) const {
+    minX = std::max(minX, 0);
+    minY = std::max(minY, 0);
+    maxX = std::min(maxX, width - 1);
+    maxY = std::min(maxY, height - 1);
+    if (minX > maxX) {
+        return;
+    }
+    
+    size_t firstBit = minX + 1;
+    size_t lastBit = maxX + 1;
+    for (int y = minY; y <= maxY; y++) {
+        if (rowWallCounts[y] == 0) {
+            continue;
+        }
+        const uint64_t* row = getWallRow(y);
+        for (size_t word = firstBit >> 6; word <= lastBit >> 6; word++) {
+            uint64_t bits = row[word] & rangeMask(word, firstBit, lastBit);
+            while (bits) {
+                visit(static_cast<int>(word * 64 + __builtin_ctzll(bits)) - 1, y);
+                bits &= bits - 1;
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef MAZEFORMAT_H
+#define MAZEFORMAT_H
+
+#include <cstdint>
+
+// Layout of a compiled maze file (.mzb), written by maze_compile.
+// All fields are little-endian. The wall section holds the exact in-memory
+// layout of Maze (padded rows of 64-bit words, one bit per cell), so a
+// mapped file is used in place without copying.
+//
+//   header | wall words | optional precomputed data
+//
+// Both sections start on an 8-byte boundary.
+const char COMPILED_MAZE_MAGIC[4] = {'M', 'Z', 'B', '1'};
+const uint32_t COMPILED_MAZE_VERSION = 1;
+
+struct CompiledMazeHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    int32_t ladderX;
+    int32_t ladderY;
+    uint32_t rowWords;
+    uint32_t reserved;
+    uint64_t wallsOffset;
+    uint64_t wallsBytes;
+    uint64_t dataOffset;     // 0 when there is no precomputed data
+    uint64_t dataBytes;
+};
+
+static_assert(sizeof(CompiledMazeHeader) == 64, "compiled maze header must stay 64 bytes");
+
+// The precomputed data section, written by MapCache:
+//
+//   PrecomputedHeader | sectionCount x PrecomputedSection | sections
+//
+// Section offsets are relative to the start of the data section and on an
+// 8-byte boundary. Readers skip kinds they don't know.
+const char PRECOMPUTED_MAGIC[4] = {'M', 'Z', 'P', '1'};
+const uint32_t PRECOMPUTED_VERSION = 1;
+
+enum PrecomputedKind : uint32_t {
+    PRECOMPUTED_DISTANCE_ORACLE = 1
+};
+
+struct PrecomputedHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceHash;      // MapCache::hashFile of the map the file was made from
+    uint32_t sectionCount;
+    uint32_t reserved;
+};
+
+struct PrecomputedSection {
+    uint32_t kind;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t bytes;
+};
+
+// A DistanceOracle section: this header, 2 * landmarkCount int32 landmark
+// coordinates, the ladder field and the interleaved landmark fields as
+// uint16 per cell, each part starting on an 8-byte boundary. mapHash is
+// Maze::getContentHash of the maze the distances are for; a file can hold
+// oracles for several, e.g. the map before and after the walls dissolve.
+struct DistanceOracleSection {
+    uint64_t mapHash;
+    uint32_t width;
+    uint32_t height;
+    uint32_t landmarkCount;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(PrecomputedHeader) == 24, "precomputed header must stay 24 bytes");
+static_assert(sizeof(PrecomputedSection) == 24, "precomputed section entry must stay 24 bytes");
+static_assert(sizeof(DistanceOracleSection) == 24, "distance oracle section header must stay 24 bytes");
+
+#endif
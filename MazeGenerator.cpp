@@ -0,0 +1,378 @@
+#include "MazeGenerator.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+// Up, right, down, left
+const int DX[4] = {0, 1, 0, -1};
+const int DY[4] = {-1, 0, 1, 0};
+
+}
+
+MazeGenerator::MazeGenerator(const MazeGeneratorOptions& generatorOptions) 
+    : options(generatorOptions), rng(generatorOptions.seed) {
+}
+
+bool MazeGenerator::parseStyle(const string& name, MazeStyle& style) {
+    if (name == "backtracker") {
+        style = MazeStyle::BACKTRACKER;
+    } else if (name == "kruskal") {
+        style = MazeStyle::KRUSKAL;
+    } else if (name == "cave") {
+        style = MazeStyle::CAVE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool MazeGenerator::parseLadderPlacement(const string& name, LadderPlacement& placement) {
+    if (name == "corner") {
+        placement = LadderPlacement::CORNER;
+    } else if (name == "far") {
+        placement = LadderPlacement::FAR;
+    } else if (name == "random") {
+        placement = LadderPlacement::RANDOM;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+Maze MazeGenerator::generate() {
+    if (options.width < 5 || options.height < 5) {
+        throw runtime_error("Generated mazes must be at least 5x5");
+    }
+    if (static_cast<long long>(options.width) * options.height > 0xFFFFFFFFLL) {
+        throw runtime_error("Generated maze is too large");
+    }
+    
+    Maze maze(options.width, options.height);
+    
+    switch (options.style) {
+        case MazeStyle::BACKTRACKER:
+            carveBacktracker(maze);
+            addLoops(maze);
+            break;
+        case MazeStyle::KRUSKAL:
+            carveKruskal(maze);
+            addLoops(maze);
+            break;
+        case MazeStyle::CAVE:
+            growCave(maze);
+            break;
+    }
+    
+    placeLadder(maze);
+    return maze;
+}
+
+void MazeGenerator::carveBacktracker(Maze& maze) {
+    // Rooms sit on odd coordinates, walls between them on even ones
+    int roomsX = (maze.getWidth() - 1) / 2;
+    int roomsY = (maze.getHeight() - 1) / 2;
+    
+    int x = 2 * rng.nextInt(roomsX) + 1;
+    int y = 2 * rng.nextInt(roomsY) + 1;
+    maze.removeWall(x, y);
+    
+    // Only the direction of each step is stored, backtracking reverses it
+    vector<uint8_t> path;
+    int choices[4];
+    
+    while (true) {
+        int count = 0;
+        for (int dir = 0; dir < 4; dir++) {
+            int nx = x + 2 * DX[dir];
+            int ny = y + 2 * DY[dir];
+            if (nx > 0 && nx < 2 * roomsX + 1 && ny > 0 && ny < 2 * roomsY + 1 && maze.isWallUnchecked(nx, ny)) {
+                choices[count++] = dir;
+            }
+        }
+        
+        if (count > 0) {
+            int dir = choices[rng.nextInt(count)];
+            maze.removeWall(x + DX[dir], y + DY[dir]);
+            x += 2 * DX[dir];
+            y += 2 * DY[dir];
+            maze.removeWall(x, y);
+            path.push_back(dir);
+        } else if (!path.empty()) {
+            int dir = path.back();
+            path.pop_back();
+            x -= 2 * DX[dir];
+            y -= 2 * DY[dir];
+        } else {
+            break;
+        }
+    }
+}
+
+void MazeGenerator::carveKruskal(Maze& maze) {
+    int roomsX = (maze.getWidth() - 1) / 2;
+    int roomsY = (maze.getHeight() - 1) / 2;
+    uint32_t rooms = static_cast<uint32_t>(roomsX) * roomsY;
+    
+    // Edge = room * 2 + (0 right, 1 down)
+    vector<uint32_t> edges;
+    edges.reserve(static_cast<size_t>(rooms) * 2);
+    for (int ry = 0; ry < roomsY; ry++) {
+        for (int rx = 0; rx < roomsX; rx++) {
+            uint32_t room = static_cast<uint32_t>(ry) * roomsX + rx;
+            maze.removeWall(2 * rx + 1, 2 * ry + 1);
+            if (rx + 1 < roomsX) edges.push_back(room * 2);
+            if (ry + 1 < roomsY) edges.push_back(room * 2 + 1);
+        }
+    }
+    rng.shuffle(edges);
+    
+    vector<uint32_t> parent(rooms);
+    vector<uint8_t> rank(rooms, 0);
+    for (uint32_t i = 0; i < rooms; i++) {
+        parent[i] = i;
+    }
+    auto findRoot = [&parent](uint32_t room) {
+        while (parent[room] != room) {
+            parent[room] = parent[parent[room]]; // Path halving
+            room = parent[room];
+        }
+        return room;
+    };
+    
+    for (uint32_t edge : edges) {
+        uint32_t room = edge / 2;
+        bool down = edge & 1;
+        uint32_t other = down ? room + roomsX : room + 1;
+        
+        uint32_t rootA = findRoot(room);
+        uint32_t rootB = findRoot(other);
+        if (rootA == rootB) {
+            continue;
+        }
+        // Union by rank keeps the trees shallow
+        if (rank[rootA] < rank[rootB]) {
+            parent[rootA] = rootB;
+        } else if (rank[rootA] > rank[rootB]) {
+            parent[rootB] = rootA;
+        } else {
+            parent[rootB] = rootA;
+            rank[rootA]++;
+        }
+        
+        int x = 2 * (room % roomsX) + 1;
+        int y = 2 * (room / roomsX) + 1;
+        maze.removeWall(down ? x : x + 1, down ? y + 1 : y);
+    }
+}
+
+void MazeGenerator::addLoops(Maze& maze) {
+    if (options.loopRatio <= 0.0) {
+        return;
+    }
+    
+    // Inner walls that separate two rooms in a straight line
+    for (int y = 1; y < maze.getHeight() - 1; y++) {
+        for (int x = 1 + (y % 2); x < maze.getWidth() - 1; x += 2) {
+            if (!maze.isWallUnchecked(x, y)) {
+                continue;
+            }
+            bool horizontal = !maze.isWallUnchecked(x - 1, y) && !maze.isWallUnchecked(x + 1, y);
+            bool vertical = !maze.isWallUnchecked(x, y - 1) && !maze.isWallUnchecked(x, y + 1);
+            if ((horizontal || vertical) && rng.nextDouble() < options.loopRatio) {
+                maze.removeWall(x, y);
+            }
+        }
+    }
+}
+
+void MazeGenerator::growCave(Maze& maze) {
+    int width = maze.getWidth();
+    int height = maze.getHeight();
+    
+    int words = maze.getRowWords();
+    vector<uint64_t> nextRow(words);
+    
+    // Random fill, built a row at a time. The outer border stays wall.
+    double density = min(max(options.wallDensity, 0.0), 1.0);
+    for (int y = 1; y < height - 1; y++) {
+        fill(nextRow.begin(), nextRow.end(), 0);
+        for (int x = 1; x < width - 1; x++) {
+            if (rng.nextDouble() < density) {
+                size_t bit = x + 1;
+                nextRow[bit >> 6] |= 1ULL << (bit & 63);
+            }
+        }
+        nextRow[0] |= 2;
+        size_t rightBorder = width;
+        nextRow[rightBorder >> 6] |= 1ULL << (rightBorder & 63);
+        maze.setWallRow(y, nextRow.data());
+    }
+    
+    // Smoothing: 5+ wall neighbours make a wall, 3 or fewer open it up.
+    // Neighbours are counted 64 cells at a time with bit-sliced adders,
+    // reading the previous generation from a copy of the rows.
+    vector<uint64_t> previous(static_cast<size_t>(height) * words);
+    
+    for (int pass = 0; pass < options.caveIterations; pass++) {
+        for (int y = 0; y < height; y++) {
+            const uint64_t* row = maze.getWallRow(y);
+            copy(row, row + words, previous.begin() + static_cast<size_t>(y) * words);
+        }
+        
+        for (int y = 1; y < height - 1; y++) {
+            const uint64_t* rows[3] = {
+                &previous[static_cast<size_t>(y - 1) * words],
+                &previous[static_cast<size_t>(y) * words],
+                &previous[static_cast<size_t>(y + 1) * words]
+            };
+            
+            for (int i = 0; i < words; i++) {
+                uint64_t count0 = 0, count1 = 0, count2 = 0, count3 = 0;
+                for (int r = 0; r < 3; r++) {
+                    uint64_t word = rows[r][i];
+                    uint64_t before = i > 0 ? rows[r][i - 1] : ~0ULL;
+                    uint64_t after = i + 1 < words ? rows[r][i + 1] : ~0ULL;
+                    uint64_t inputs[3] = {
+                        (word << 1) | (before >> 63),   // left neighbour
+                        word,
+                        (word >> 1) | (after << 63)     // right neighbour
+                    };
+                    for (int k = 0; k < 3; k++) {
+                        if (r == 1 && k == 1) {
+                            continue; // The cell itself
+                        }
+                        uint64_t carry0 = count0 & inputs[k];
+                        count0 ^= inputs[k];
+                        uint64_t carry1 = count1 & carry0;
+                        count1 ^= carry0;
+                        uint64_t carry2 = count2 & carry1;
+                        count2 ^= carry1;
+                        count3 |= carry2;
+                    }
+                }
+                uint64_t atLeastFive = count3 | (count2 & (count1 | count0));
+                uint64_t exactlyFour = count2 & ~count1 & ~count0 & ~count3;
+                nextRow[i] = atLeastFive | (exactlyFour & rows[1][i]);
+            }
+            
+            // The map border stays wall, setWallRow restores the padding
+            nextRow[0] |= 2;
+            size_t rightBorder = maze.getWidth();
+            nextRow[rightBorder >> 6] |= 1ULL << (rightBorder & 63);
+            maze.setWallRow(y, nextRow.data());
+        }
+    }
+    
+    // Keep only the cavern around the centre so every open cell is reachable
+    pair<int, int> start = {-1, -1};
+    for (int radius = 0; radius < max(width, height) && start.first < 0; radius++) {
+        for (int y = height / 2 - radius; y <= height / 2 + radius && start.first < 0; y++) {
+            for (int x = width / 2 - radius; x <= width / 2 + radius; x++) {
+                if (maze.isValidPosition(x, y) && !maze.isWallUnchecked(x, y)) {
+                    start = {x, y};
+                    break;
+                }
+            }
+        }
+    }
+    if (start.first < 0) {
+        throw runtime_error("Generated cave has no open cells, lower the wall density");
+    }
+    floodFill(maze, start.first, start.second, true);
+}
+
+pair<int, int> MazeGenerator::floodFill(Maze& maze, int startX, int startY, bool fillUnreached) {
+    int width = maze.getWidth();
+    size_t cells = static_cast<size_t>(width) * maze.getHeight();
+    vector<uint64_t> reached((cells + 63) / 64, 0);
+    
+    uint32_t startCell = static_cast<uint32_t>(startY) * width + startX;
+    reached[startCell >> 6] |= 1ULL << (startCell & 63);
+    
+    // Level by level, so only the current and next frontier are stored
+    vector<uint32_t> current(1, startCell);
+    vector<uint32_t> next;
+    
+    uint32_t last = startCell;
+    while (!current.empty()) {
+        last = current.back();
+        next.clear();
+        for (uint32_t cell : current) {
+            int x = cell % width;
+            int y = cell / width;
+            for (int dir = 0; dir < 4; dir++) {
+                int nx = x + DX[dir];
+                int ny = y + DY[dir];
+                if (maze.isWallUnchecked(nx, ny)) {
+                    continue; // The wall border keeps the fill inside the map
+                }
+                uint32_t neighbour = static_cast<uint32_t>(ny) * width + nx;
+                if ((reached[neighbour >> 6] >> (neighbour & 63)) & 1) {
+                    continue;
+                }
+                reached[neighbour >> 6] |= 1ULL << (neighbour & 63);
+                next.push_back(neighbour);
+            }
+        }
+        current.swap(next);
+    }
+    
+    if (fillUnreached) {
+        for (int y = 0; y < maze.getHeight(); y++) {
+            for (int x = 0; x < width; x++) {
+                size_t cell = static_cast<size_t>(y) * width + x;
+                if (!maze.isWallUnchecked(x, y) && !((reached[cell >> 6] >> (cell & 63)) & 1)) {
+                    maze.setCell(x, y, '*');
+                }
+            }
+        }
+    }
+    
+    return {static_cast<int>(last % width), static_cast<int>(last / width)};
+}
+
+pair<int, int> MazeGenerator::firstOpenCell(const Maze& maze) const {
+    for (int y = 0; y < maze.getHeight(); y++) {
+        for (int x = 0; x < maze.getWidth(); x++) {
+            if (!maze.isWallUnchecked(x, y)) {
+                return {x, y};
+            }
+        }
+    }
+    throw runtime_error("Generated maze has no open cells");
+}
+
+pair<int, int> MazeGenerator::lastOpenCell(const Maze& maze) const {
+    for (int y = maze.getHeight() - 1; y >= 0; y--) {
+        for (int x = maze.getWidth() - 1; x >= 0; x--) {
+            if (!maze.isWallUnchecked(x, y)) {
+                return {x, y};
+            }
+        }
+    }
+    throw runtime_error("Generated maze has no open cells");
+}
+
+void MazeGenerator::placeLadder(Maze& maze) {
+    pair<int, int> ladder = lastOpenCell(maze);
+    
+    if (options.ladder == LadderPlacement::FAR) {
+        pair<int, int> start = firstOpenCell(maze);
+        ladder = floodFill(maze, start.first, start.second, false);
+    } else if (options.ladder == LadderPlacement::RANDOM) {
+        // Rejection sampling, open cells are a large share of every style
+        for (int attempt = 0; attempt < 10000; attempt++) {
+            int x = rng.nextInt(maze.getWidth());
+            int y = rng.nextInt(maze.getHeight());
+            if (!maze.isWallUnchecked(x, y)) {
+                ladder = {x, y};
+                break;
+            }
+        }
+    }
+    
+    maze.setLadder(ladder.first, ladder.second);
+}
@@ -0,0 +1,67 @@
+#ifndef MAZEGENERATOR_H
+#define MAZEGENERATOR_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "Maze.h"
+#include "Rng.h"
+
+enum class MazeStyle {
+    BACKTRACKER,   // long winding corridors, recursive backtracker
+    KRUSKAL,       // many short dead ends, randomized Kruskal
+    CAVE           // open caverns, cellular automaton
+};
+
+enum class LadderPlacement {
+    CORNER,        // last open cell, bottom right like the shipped maps
+    FAR,           // open cell farthest from the top left
+    RANDOM         // any open cell
+};
+
+struct MazeGeneratorOptions {
+    MazeStyle style;
+    int width;
+    int height;
+    double wallDensity;     // CAVE: initial share of walls
+    double loopRatio;       // BACKTRACKER/KRUSKAL: share of inner walls knocked out
+    int caveIterations;     // CAVE: smoothing passes
+    LadderPlacement ladder;
+    uint64_t seed;
+    
+    MazeGeneratorOptions() 
+        : style(MazeStyle::BACKTRACKER), width(33), height(29), wallDensity(0.45), loopRatio(0.05),
+          caveIterations(4), ladder(LadderPlacement::CORNER), seed(0) {}
+};
+
+// Builds large random mazes for scaling tests. Walls are written straight
+// into the Maze bitset and the helper structures stay compact (a direction
+// byte per step for the backtracker, a visited bitset for flood fills), so
+// 10^8-cell mazes are practical.
+class MazeGenerator {
+public:
+    explicit MazeGenerator(const MazeGeneratorOptions& generatorOptions);
+    
+    Maze generate();
+    
+    static bool parseStyle(const std::string& name, MazeStyle& style);
+    static bool parseLadderPlacement(const std::string& name, LadderPlacement& placement);
+    
+private:
+    MazeGeneratorOptions options;
+    Rng rng;
+    
+    void carveBacktracker(Maze& maze);
+    void carveKruskal(Maze& maze);
+    void addLoops(Maze& maze);
+    void growCave(Maze& maze);
+    
+    // Flood fill from (startX, startY). Returns the last cell reached, which
+    // is the farthest one, and optionally walls off everything unreachable.
+    std::pair<int, int> floodFill(Maze& maze, int startX, int startY, bool fillUnreached);
+    std::pair<int, int> firstOpenCell(const Maze& maze) const;
+    std::pair<int, int> lastOpenCell(const Maze& maze) const;
+    void placeLadder(Maze& maze);
+};
+
+#endif
@@ -0,0 +1,239 @@
+#include "NcursesRenderer.h"
+#include "Maze.h"
+#include <algorithm>
+#include <ncurses.h>
+#include <unistd.h>
+
+using namespace std;
+
+NcursesRenderer::NcursesRenderer() : started(false), needsFullRedraw(true) {
+}
+
+NcursesRenderer::~NcursesRenderer() {
+    if (started) {
+        endwin(); // Clean up ncurses
+    }
+}
+
+void NcursesRenderer::init(const Maze* maze) {
+    // Initialize ncurses
+    initscr();
+    cbreak();
+    noecho();
+    nodelay(stdscr, TRUE);
+    curs_set(0); 
+    keypad(stdscr, TRUE); // Report terminal resizes as KEY_RESIZE
+    started = true;
+    needsFullRedraw = true;
+    
+    // Initialize colors
+    if (has_colors()) {
+        start_color();
+        init_pair(1, COLOR_RED, COLOR_BLACK);    // Heroes
+        init_pair(2, COLOR_YELLOW, COLOR_BLACK); // Key
+        init_pair(3, COLOR_GREEN, COLOR_BLACK);  // Ladder
+        init_pair(4, COLOR_MAGENTA, COLOR_BLACK); // Cages
+        init_pair(5, COLOR_CYAN, COLOR_BLACK);   // Info text
+    }
+}
+
+void NcursesRenderer::drawFrame(const Maze* maze, const RenderFrame& frame) {
+    if (needsFullRedraw) {
+        drawEverything(maze, frame);
+        return;
+    }
+    
+    collectSprites(maze, frame, nextSprites);
+    
+    // Candidates: where sprites were, where they are now and changed maze
+    // cells. Changed cells are flagged because their old look is unknown.
+    dirtyCells.clear();
+    for (const auto& sprite : drawnSprites) {
+        dirtyCells.push_back(sprite.cell * 2);
+    }
+    for (const auto& sprite : nextSprites) {
+        dirtyCells.push_back(sprite.cell * 2);
+    }
+    for (const auto& changed : frame.changedCells) {
+        if (maze->isValidPosition(changed.first, changed.second)) {
+            dirtyCells.push_back((static_cast<long long>(changed.second) * maze->getWidth() + changed.first) * 2 + 1);
+        }
+    }
+    sort(dirtyCells.begin(), dirtyCells.end());
+    
+    int runY = -1;
+    int runStartX = 0;
+    int runColor = 0;
+    runText.clear();
+    
+    for (size_t i = 0; i < dirtyCells.size(); i++) {
+        long long cell = dirtyCells[i] / 2;
+        bool forced = dirtyCells[i] & 1;
+        while (i + 1 < dirtyCells.size() && dirtyCells[i + 1] / 2 == cell) {
+            i++;
+            forced = forced || (dirtyCells[i] & 1);
+        }
+        
+        CellContent now = contentAt(maze, cell, nextSprites);
+        if (!forced) {
+            CellContent before = contentAt(maze, cell, drawnSprites);
+            if (before.symbol == now.symbol && before.colorPair == now.colorPair) {
+                continue;
+            }
+        }
+        
+        int y = cell / maze->getWidth();
+        int x = cell % maze->getWidth();
+        bool extendsRun = !runText.empty() && y == runY && 
+                          x == runStartX + static_cast<int>(runText.size()) && now.colorPair == runColor;
+        if (!extendsRun) {
+            flushRun(runY, runStartX, runColor);
+            runY = y;
+            runStartX = x;
+            runColor = now.colorPair;
+        }
+        runText += now.symbol;
+    }
+    flushRun(runY, runStartX, runColor);
+    
+    if (frame.status != drawnStatus) {
+        drawStatus(maze, frame.status);
+    }
+    drawMessage(maze);
+    
+    drawnSprites.swap(nextSprites);
+    refresh();
+}
+
+void NcursesRenderer::drawEverything(const Maze* maze, const RenderFrame& frame) {
+    clear();
+    
+    // Display maze
+    maze->display();
+    
+    // Display objects, in the order Game placed them
+    for (const auto& sprite : frame.sprites) {
+        attron(COLOR_PAIR(sprite.colorPair));
+        mvaddch(sprite.y, sprite.x, sprite.symbol);
+        attroff(COLOR_PAIR(sprite.colorPair));
+    }
+    
+    drawStatus(maze, frame.status);
+    drawnMessage.clear();
+    drawMessage(maze);
+    
+    collectSprites(maze, frame, drawnSprites);
+    needsFullRedraw = false;
+    refresh();
+}
+
+void NcursesRenderer::drawStatus(const Maze* maze, const string& status) {
+    move(maze->getHeight() + 4, 0);
+    clrtoeol();
+    if (!status.empty()) {
+        attron(COLOR_PAIR(5));
+        mvprintw(maze->getHeight() + 4, 0, "%s", status.c_str());
+        attroff(COLOR_PAIR(5));
+    }
+    drawnStatus = status;
+}
+
+void NcursesRenderer::collectSprites(const Maze* maze, const RenderFrame& frame, 
+                                     vector<CellContent>& target) const {
+    target.clear();
+    for (const auto& sprite : frame.sprites) {
+        if (maze->isValidPosition(sprite.x, sprite.y)) {
+            long long cell = static_cast<long long>(sprite.y) * maze->getWidth() + sprite.x;
+            target.push_back({cell, sprite.symbol, sprite.colorPair});
+        }
+    }
+    
+    // Later sprites are drawn on top, keep only the last one per cell
+    stable_sort(target.begin(), target.end(), 
+                [](const CellContent& a, const CellContent& b) { return a.cell < b.cell; });
+    size_t kept = 0;
+    for (size_t i = 0; i < target.size(); i++) {
+        if (kept > 0 && target[kept - 1].cell == target[i].cell) {
+            target[kept - 1] = target[i];
+        } else {
+            target[kept++] = target[i];
+        }
+    }
+    target.resize(kept);
+}
+
+NcursesRenderer::CellContent NcursesRenderer::contentAt(const Maze* maze, long long cell, 
+                                                        const vector<CellContent>& sprites) const {
+    auto found = lower_bound(sprites.begin(), sprites.end(), cell, 
+                             [](const CellContent& content, long long value) { return content.cell < value; });
+    if (found != sprites.end() && found->cell == cell) {
+        return *found;
+    }
+    
+    int y = cell / maze->getWidth();
+    int x = cell % maze->getWidth();
+    if (x == maze->getLadderX() && y == maze->getLadderY()) {
+        return {cell, 'L', 3}; // Special color for ladder
+    }
+    return {cell, maze->getCell(x, y), 0};
+}
+
+void NcursesRenderer::flushRun(int y, int startX, int colorPair) {
+    if (runText.empty()) {
+        return;
+    }
+    attron(COLOR_PAIR(colorPair));
+    mvaddnstr(y, startX, runText.c_str(), runText.size());
+    attroff(COLOR_PAIR(colorPair));
+    runText.clear();
+}
+
+void NcursesRenderer::drawMessage(const Maze* maze) {
+    string latest;
+    {
+        lock_guard<mutex> lock(messageMutex);
+        latest = message;
+    }
+    if (latest == drawnMessage) {
+        return;
+    }
+    move(maze->getHeight() + 5, 0);
+    clrtoeol();
+    mvprintw(maze->getHeight() + 5, 0, "%s", latest.c_str());
+    drawnMessage = latest;
+}
+
+void NcursesRenderer::logMessage(const string& text) {
+    lock_guard<mutex> lock(messageMutex);
+    message = text;
+}
+
+void NcursesRenderer::showResult(const Maze* maze, bool won) {
+    clear();
+    if (won) {
+        attron(COLOR_PAIR(3));
+        mvprintw(maze->getHeight()/2, maze->getWidth()/2 - 15, "Congratulations! The heroes saved the kingdom!");
+        attroff(COLOR_PAIR(3));
+    } else {
+        attron(COLOR_PAIR(1));
+        mvprintw(maze->getHeight()/2, maze->getWidth()/2 - 12, "Game Over! The kingdom has fallen...");
+        attroff(COLOR_PAIR(1));
+    }
+    mvprintw(maze->getHeight()/2 + 2, maze->getWidth()/2 - 12, "Press any key to exit...");
+    refresh();
+    
+    nodelay(stdscr, FALSE);
+    getch();
+}
+
+int NcursesRenderer::readKey() {
+    int ch = getch();
+    if (ch == KEY_RESIZE) {
+        needsFullRedraw = true;
+    }
+    return ch == ERR ? -1 : ch;
+}
+
+int NcursesRenderer::getInputFd() const {
+    return STDIN_FILENO;
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef NCURSESRENDERER_H
+#define NCURSESRENDERER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include "Renderer.h"
+
+// Draws the whole maze once, then only the cells that changed between
+// frames: old and new sprite positions and removed walls. Cells are drawn
+// in row order and neighbouring cells with the same color go out as one
+// string, so the work per frame follows the number of changes. Log
+// messages show on a line below the status instead of going to stdout,
+// which ncurses owns while the game runs.
+class NcursesRenderer : public Renderer {
+public:
+    NcursesRenderer();
+    ~NcursesRenderer();
+    
+    void init(const Maze* maze) override;
+    void drawFrame(const Maze* maze, const RenderFrame& frame) override;
+    void logMessage(const std::string& message) override;
+    void showResult(const Maze* maze, bool won) override;
+    int readKey() override;
+    int getInputFd() const override;
+    
+private:
+    // What is on screen at one cell, ordered by position
+    struct CellContent {
+        long long cell;
+        char symbol;
+        int colorPair;
+    };
+    
+    bool started;
+    bool needsFullRedraw;
+    std::string drawnStatus;
+    
+    // logMessage can come from the simulation thread, the text is only
+    // drawn by drawFrame on the render thread
+    std::mutex messageMutex;
+    std::string message;
+    std::string drawnMessage;
+    
+    std::vector<CellContent> drawnSprites;
+    std::vector<CellContent> nextSprites;
+    std::vector<long long> dirtyCells;
+    std::string runText;
+    
+    void drawEverything(const Maze* maze, const RenderFrame& frame);
+    void drawStatus(const Maze* maze, const std::string& status);
+    void drawMessage(const Maze* maze);
+    void collectSprites(const Maze* maze, const RenderFrame& frame, std::vector<CellContent>& target) const;
+    CellContent contentAt(const Maze* maze, long long cell, const std::vector<CellContent>& sprites) const;
+    void flushRun(int y, int startX, int colorPair);
+};
+
+#endif
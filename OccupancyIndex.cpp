@@ -0,0 +1,80 @@
+#include "OccupancyIndex.h"
+
+using namespace std;
+
+OccupancyIndex::OccupancyIndex() : mask(0), used(0) {
+}
+
+OccupancyIndex::Cell& OccupancyIndex::get(long long cell) {
+    // Keep the table at most half full so probe chains stay short
+    if ((used + 1) * 2 > slots.size()) {
+        grow();
+    }
+    
+    size_t i = slotFor(cell);
+    while (slots[i].cell != EMPTY) {
+        if (slots[i].cell == cell) {
+            return slots[i].content;
+        }
+        i = (i + 1) & mask;
+    }
+    slots[i].cell = cell;
+    slots[i].content = {-1, -1, -1};
+    used++;
+    return slots[i].content;
+}
+
+void OccupancyIndex::release(long long cell) {
+    if (slots.empty()) {
+        return;
+    }
+    size_t i = slotFor(cell);
+    while (slots[i].cell != cell) {
+        if (slots[i].cell == EMPTY) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+    const Cell& content = slots[i].content;
+    if (content.firstHero >= 0 || content.trap >= 0 || content.key >= 0) {
+        return;
+    }
+    
+    // Backward shift deletion: pull later entries of the probe chain
+    // into the hole so lookups never need tombstones
+    size_t hole = i;
+    for (size_t j = (hole + 1) & mask; slots[j].cell != EMPTY; j = (j + 1) & mask) {
+        size_t home = slotFor(slots[j].cell);
+        // Move j into the hole unless its home lies cyclically in (hole, j]
+        bool homeBetween = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (!homeBetween) {
+            slots[hole] = slots[j];
+            hole = j;
+        }
+    }
+    slots[hole].cell = EMPTY;
+    used--;
+}
+
+void OccupancyIndex::clear() {
+    for (auto& slot : slots) {
+        slot.cell = EMPTY;
+    }
+    used = 0;
+}
+
+void OccupancyIndex::grow() {
+    vector<Slot> old;
+    old.swap(slots);
+    
+    size_t capacity = old.empty() ? 16 : old.size() * 2;
+    slots.assign(capacity, Slot{EMPTY, {-1, -1, -1}});
+    mask = capacity - 1;
+    used = 0;
+    
+    for (const auto& slot : old) {
+        if (slot.cell != EMPTY) {
+            get(slot.cell) = slot.content;
+        }
+    }
+}
\ No newline at end of file
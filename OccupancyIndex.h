@@ -0,0 +1,67 @@
+#ifndef OCCUPANCYINDEX_H
+#define OCCUPANCYINDEX_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// What stands on each occupied cell, in an open-addressing hash table
+// keyed by y * width + x. Only occupied cells take space, so the index
+// stays small on huge maps, and lookups are O(1) however many entities
+// the game has. Entities are referred to by their index in Game's tables.
+class OccupancyIndex {
+public:
+    struct Cell {
+        int firstHero;    // head of the hero list for this cell, see Game::heroNext
+        int trap;
+        int key;
+    };
+    
+    OccupancyIndex();
+    
+    // nullptr when nothing stands on the cell
+    const Cell* find(long long cell) const {
+        if (slots.empty()) {
+            return nullptr;
+        }
+        for (size_t i = slotFor(cell); ; i = (i + 1) & mask) {
+            const Slot& slot = slots[i];
+            if (slot.cell == cell) {
+                return &slot.content;
+            }
+            if (slot.cell == EMPTY) {
+                return nullptr;
+            }
+        }
+    }
+    
+    // Creates an empty entry when needed
+    Cell& get(long long cell);
+    
+    // Drops the entry once nothing refers to the cell any more
+    void release(long long cell);
+    
+    void clear();
+    size_t size() const { return used; }
+    
+private:
+    static const long long EMPTY = -1;
+    
+    struct Slot {
+        long long cell;
+        Cell content;
+    };
+    
+    std::vector<Slot> slots;
+    size_t mask;
+    size_t used;
+    
+    size_t slotFor(long long cell) const {
+        // Fibonacci hashing spreads neighbouring cells over the table
+        return static_cast<size_t>((static_cast<uint64_t>(cell) * 0x9E3779B97F4A7C15ULL) >> 20) & mask;
+    }
+    
+    void grow();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "Pathfinder.h"
+
+using namespace std;
+
+// Same order as Hero::getValidMoves: up, right, down, left
+const int Pathfinder::DX[4] = {0, 1, 0, -1};
+const int Pathfinder::DY[4] = {-1, 0, 1, 0};
+
+Pathfinder::Pathfinder() 
+    : areaX(0), areaY(0), areaWidth(0), areaHeight(0), generation(0), lastPathLength(-1) {
+}
+
+void Pathfinder::beginSearch(int minX, int minY, int maxX, int maxY) {
+    areaX = minX;
+    areaY = minY;
+    areaWidth = maxX - minX + 1;
+    areaHeight = maxY - minY + 1;
+    
+    size_t cells = static_cast<size_t>(areaWidth) * areaHeight;
+    if (seenStamp.size() < cells) {
+        seenStamp.resize(cells, 0);
+        closedStamp.resize(cells, 0);
+        costSoFar.resize(cells, 0);
+        cameFrom.resize(cells, 0);
+    }
+    
+    // A new generation invalidates every stamp without touching the buffers
+    generation++;
+    if (generation == 0) {
+        fill(seenStamp.begin(), seenStamp.end(), 0);
+        fill(closedStamp.begin(), closedStamp.end(), 0);
+        generation = 1;
+    }
+    openList.clear();
+    searchQueue.clear();
+}
+
+pair<int, int> Pathfinder::firstStepTo(int goalIndex, int startIndex) {
+    int index = goalIndex;
+    while (true) {
+        int dir = cameFrom[index];
+        int previous = index - DY[dir] * areaWidth - DX[dir];
+        if (previous == startIndex) {
+            break;
+        }
+        index = previous;
+    }
+    return {index % areaWidth + areaX, index / areaWidth + areaY};
+}
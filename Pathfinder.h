@@ -0,0 +1,227 @@
+#ifndef PATHFINDER_H
+#define PATHFINDER_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include "Profiler.h"
+
+// Shortest paths on a 4-connected grid, restricted to a rectangular
+// search area. Cells are tested through a callback, so the same engine
+// works on the real Maze and on a hero's knownMap. The buffers grow to
+// the largest area searched so far and are reused, so a query does not
+// allocate once the pathfinder has warmed up.
+class Pathfinder {
+public:
+    Pathfinder();
+    
+    // A* from start to goal inside [minX, maxX] x [minY, maxY].
+    // isOpen(x, y) is only called for cells inside that area.
+    // Returns the first step of a shortest path, or the start position if
+    // the goal can't be reached (or maxExpansions > 0 is exceeded).
+    template <typename IsOpen>
+    std::pair<int, int> findNextStep(int minX, int minY, int maxX, int maxY,
+                                     int startX, int startY, int goalX, int goalY,
+                                     IsOpen isOpen, int maxExpansions = 0);
+    
+    // The same with heuristic(x, y) in place of the Manhattan distance to
+    // the goal, e.g. DistanceOracle::lowerBound. It must never overestimate
+    // the remaining steps, or the path found may not be the shortest.
+    template <typename IsOpen, typename Heuristic>
+    std::pair<int, int> findNextStepWithHeuristic(int minX, int minY, int maxX, int maxY,
+                                                  int startX, int startY, int goalX, int goalY,
+                                                  IsOpen isOpen, Heuristic heuristic, int maxExpansions = 0);
+    
+    // Breadth-first search from start to the closest cell with isGoal(x, y),
+    // walking only through cells with isOpen(x, y). Same return convention.
+    template <typename IsOpen, typename IsGoal>
+    std::pair<int, int> findNextStepToNearest(int minX, int minY, int maxX, int maxY,
+                                              int startX, int startY,
+                                              IsOpen isOpen, IsGoal isGoal, int maxExpansions = 0);
+    
+    // Length in steps of the last path found, -1 if there was none
+    int getLastPathLength() const { return lastPathLength; }
+    
+private:
+    struct OpenNode {
+        uint32_t estimate;   // cost so far + heuristic
+        uint32_t heuristic;
+        int index;
+    };
+    
+    // Lower estimate first, then closer to the goal
+    struct OpenNodeOrder {
+        bool operator()(const OpenNode& a, const OpenNode& b) const {
+            if (a.estimate != b.estimate) return a.estimate > b.estimate;
+            if (a.heuristic != b.heuristic) return a.heuristic > b.heuristic;
+            return a.index > b.index;
+        }
+    };
+    
+    int areaX, areaY, areaWidth, areaHeight;
+    uint32_t generation;
+    int lastPathLength;
+    
+    // A cell belongs to the current search when its stamp equals generation
+    std::vector<uint32_t> seenStamp;
+    std::vector<uint32_t> closedStamp;
+    std::vector<uint32_t> costSoFar;
+    std::vector<uint8_t> cameFrom;
+    std::vector<OpenNode> openList;
+    std::vector<int> searchQueue;
+    
+    static const int DX[4];
+    static const int DY[4];
+    
+    void beginSearch(int minX, int minY, int maxX, int maxY);
+    std::pair<int, int> firstStepTo(int goalIndex, int startIndex);
+};
+
+template <typename IsOpen>
+std::pair<int, int> Pathfinder::findNextStep(int minX, int minY, int maxX, int maxY,
+                                             int startX, int startY, int goalX, int goalY,
+                                             IsOpen isOpen, int maxExpansions) {
+    return findNextStepWithHeuristic(minX, minY, maxX, maxY, startX, startY, goalX, goalY, isOpen,
+        [goalX, goalY](int x, int y) { return std::abs(x - goalX) + std::abs(y - goalY); },
+        maxExpansions);
+}
+
+template <typename IsOpen, typename Heuristic>
+std::pair<int, int> Pathfinder::findNextStepWithHeuristic(int minX, int minY, int maxX, int maxY,
+                                                          int startX, int startY, int goalX, int goalY,
+                                                          IsOpen isOpen, Heuristic heuristic, int maxExpansions) {
+    lastPathLength = -1;
+    if (startX < minX || startX > maxX || startY < minY || startY > maxY ||
+        goalX < minX || goalX > maxX || goalY < minY || goalY > maxY) {
+        return {startX, startY};
+    }
+    if (startX == goalX && startY == goalY) {
+        lastPathLength = 0;
+        return {startX, startY};
+    }
+    
+    beginSearch(minX, minY, maxX, maxY);
+    
+    int startIndex = (startY - areaY) * areaWidth + (startX - areaX);
+    int goalIndex = (goalY - areaY) * areaWidth + (goalX - areaX);
+    uint32_t startHeuristic = heuristic(startX, startY);
+    
+    seenStamp[startIndex] = generation;
+    costSoFar[startIndex] = 0;
+    openList.push_back({startHeuristic, startHeuristic, startIndex});
+    
+    int expansions = 0;
+    while (!openList.empty()) {
+        std::pop_heap(openList.begin(), openList.end(), OpenNodeOrder());
+        OpenNode node = openList.back();
+        openList.pop_back();
+        
+        if (closedStamp[node.index] == generation) {
+            continue; // Stale entry, a cheaper one was expanded already
+        }
+        closedStamp[node.index] = generation;
+        
+        if (node.index == goalIndex) {
+            PROFILE_COUNT(ProfileCounter::PATH_EXPANSIONS, expansions);
+            lastPathLength = costSoFar[goalIndex];
+            return firstStepTo(goalIndex, startIndex);
+        }
+        
+        if (++expansions > maxExpansions && maxExpansions > 0) {
+            break;
+        }
+        
+        int nodeX = node.index % areaWidth + areaX;
+        int nodeY = node.index / areaWidth + areaY;
+        uint32_t nextCost = costSoFar[node.index] + 1;
+        
+        for (int dir = 0; dir < 4; dir++) {
+            int nextX = nodeX + DX[dir];
+            int nextY = nodeY + DY[dir];
+            if (nextX < minX || nextX > maxX || nextY < minY || nextY > maxY) {
+                continue;
+            }
+            
+            int nextIndex = node.index + DY[dir] * areaWidth + DX[dir];
+            if (closedStamp[nextIndex] == generation) {
+                continue;
+            }
+            if (seenStamp[nextIndex] == generation && costSoFar[nextIndex] <= nextCost) {
+                continue;
+            }
+            if (!isOpen(nextX, nextY)) {
+                continue;
+            }
+            
+            seenStamp[nextIndex] = generation;
+            costSoFar[nextIndex] = nextCost;
+            cameFrom[nextIndex] = dir;
+            
+            uint32_t remaining = heuristic(nextX, nextY);
+            openList.push_back({nextCost + remaining, remaining, nextIndex});
+            std::push_heap(openList.begin(), openList.end(), OpenNodeOrder());
+        }
+    }
+    
+    PROFILE_COUNT(ProfileCounter::PATH_EXPANSIONS, expansions);
+    return {startX, startY};
+}
+
+template <typename IsOpen, typename IsGoal>
+std::pair<int, int> Pathfinder::findNextStepToNearest(int minX, int minY, int maxX, int maxY,
+                                                      int startX, int startY,
+                                                      IsOpen isOpen, IsGoal isGoal, int maxExpansions) {
+    lastPathLength = -1;
+    if (startX < minX || startX > maxX || startY < minY || startY > maxY) {
+        return {startX, startY};
+    }
+    
+    beginSearch(minX, minY, maxX, maxY);
+    
+    int startIndex = (startY - areaY) * areaWidth + (startX - areaX);
+    seenStamp[startIndex] = generation;
+    costSoFar[startIndex] = 0;
+    searchQueue.push_back(startIndex);
+    
+    // The queue is never popped, a read position walks over it instead
+    for (size_t head = 0; head < searchQueue.size(); head++) {
+        int index = searchQueue[head];
+        int cellX = index % areaWidth + areaX;
+        int cellY = index / areaWidth + areaY;
+        
+        if (index != startIndex && isGoal(cellX, cellY)) {
+            PROFILE_COUNT(ProfileCounter::PATH_EXPANSIONS, head);
+            lastPathLength = costSoFar[index];
+            return firstStepTo(index, startIndex);
+        }
+        
+        if (maxExpansions > 0 && static_cast<int>(head) >= maxExpansions) {
+            break;
+        }
+        
+        for (int dir = 0; dir < 4; dir++) {
+            int nextX = cellX + DX[dir];
+            int nextY = cellY + DY[dir];
+            if (nextX < minX || nextX > maxX || nextY < minY || nextY > maxY) {
+                continue;
+            }
+            
+            int nextIndex = index + DY[dir] * areaWidth + DX[dir];
+            if (seenStamp[nextIndex] == generation || !isOpen(nextX, nextY)) {
+                continue;
+            }
+            
+            seenStamp[nextIndex] = generation;
+            costSoFar[nextIndex] = costSoFar[index] + 1;
+            cameFrom[nextIndex] = dir;
+            searchQueue.push_back(nextIndex);
+        }
+    }
+    
+    PROFILE_COUNT(ProfileCounter::PATH_EXPANSIONS, searchQueue.size());
+    return {startX, startY};
+}
+
+#endif
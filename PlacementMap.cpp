@@ -0,0 +1,294 @@
+#include "PlacementMap.h"
+#include "Maze.h"
+#include "Rng.h"
+#include "MapHashCache.h"
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+// Bits firstBit..lastBit of a padded row that fall into the given word, as in Maze
+static uint64_t rangeMask(size_t word, size_t firstBit, size_t lastBit) {
+    uint64_t mask = ~0ULL;
+    if (word == firstBit >> 6) {
+        mask &= ~0ULL << (firstBit & 63);
+    }
+    if (word == lastBit >> 6) {
+        mask &= ~0ULL >> (63 - (lastBit & 63));
+    }
+    return mask;
+}
+
+// Walls around the run of open cells through bit; the border bits are
+// always set, so both searches stop inside the row
+static size_t previousWall(const uint64_t* walls, size_t bit) {
+    size_t word = bit >> 6;
+    uint64_t bits = walls[word] & (~0ULL >> (63 - (bit & 63)));
+    while (bits == 0) {
+        bits = walls[--word];
+    }
+    return word * 64 + 63 - __builtin_clzll(bits);
+}
+
+static size_t nextWall(const uint64_t* walls, size_t bit) {
+    size_t word = bit >> 6;
+    uint64_t bits = walls[word] & (~0ULL << (bit & 63));
+    while (bits == 0) {
+        bits = walls[++word];
+    }
+    return word * 64 + __builtin_ctzll(bits);
+}
+
+shared_ptr<const PlacementMap> PlacementMap::get(const Maze& maze, size_t minimumCells) {
+    static MapHashCache<PlacementMap> cache;
+    return cache.get(maze.getContentHash(), 
+        [&](const PlacementMap& placement) {
+            // The same choice between the ladder's part and the largest one
+            bool sameChoice = placement.ladderPart ? placement.cellCount >= minimumCells 
+                                                   : placement.ladderCells < minimumCells;
+            return placement.width == maze.getWidth() && placement.height == maze.getHeight() && sameChoice;
+        }, 
+        [&]() { return make_shared<const PlacementMap>(maze, minimumCells); });
+}
+
+PlacementMap::PlacementMap(const Maze& maze, size_t minimumCells) 
+    : width(maze.getWidth()), height(maze.getHeight()), rowWords(maze.getRowWords()), 
+      ladderPart(false), ladderCells(0), cellCount(0) {
+    
+    size_t words = static_cast<size_t>(height + 2) * rowWords;
+    bits.assign(words, 0);
+    vector<Span> stack;
+    int ladderX = maze.getLadderX();
+    int ladderY = maze.getLadderY();
+    if (maze.isValidPosition(ladderX, ladderY) && !maze.isWall(ladderX, ladderY)) {
+        fill(maze, ladderX, ladderY, bits, stack);
+        finish(maze);
+        ladderCells = cellCount;
+        if (cellCount >= minimumCells) {
+            ladderPart = true;
+            return;
+        }
+    }
+    
+    // Otherwise the largest part: every part is filled once, then the best again
+    vector<uint64_t> seen(words, 0);
+    size_t bestSize = 0;
+    int bestX = -1;
+    int bestY = -1;
+    for (int y = 1; y < height - 1; y++) {
+        const uint64_t* walls = maze.getWallRow(y);
+        const uint64_t* seenRow = seen.data() + static_cast<size_t>(y + 1) * rowWords;
+        for (size_t word = 0; word < rowWords; word++) {
+            uint64_t open = ~walls[word] & ~seenRow[word];
+            while (open) {
+                int x = static_cast<int>(word * 64 + __builtin_ctzll(open)) - 1;
+                size_t size = fill(maze, x, y, seen, stack);
+                if (size > bestSize) {
+                    bestSize = size;
+                    bestX = x;
+                    bestY = y;
+                }
+                open &= ~seenRow[word];
+            }
+        }
+    }
+    
+    bits.assign(words, 0);
+    if (bestSize > 0) {
+        fill(maze, bestX, bestY, bits, stack);
+    }
+    finish(maze);
+}
+
+size_t PlacementMap::fill(const Maze& maze, int x, int y, vector<uint64_t>& reached, vector<Span>& stack) const {
+    size_t cells = 0;
+    // Marks the whole run of open cells through bit in row runY
+    auto markRun = [&](int runY, size_t bit) {
+        const uint64_t* walls = maze.getWallRow(runY);
+        uint64_t* row = reached.data() + static_cast<size_t>(runY + 1) * rowWords;
+        Span span = {runY, previousWall(walls, bit) + 1, nextWall(walls, bit) - 1};
+        for (size_t word = span.first >> 6; word <= span.last >> 6; word++) {
+            row[word] |= rangeMask(word, span.first, span.last);
+        }
+        cells += span.last - span.first + 1;
+        stack.push_back(span);
+    };
+    
+    markRun(y, static_cast<size_t>(x) + 1);
+    while (!stack.empty()) {
+        Span span = stack.back();
+        stack.pop_back();
+        for (int nextY = span.y - 1; nextY <= span.y + 1; nextY += 2) {
+            if (nextY < 0 || nextY >= height) {
+                continue;
+            }
+            const uint64_t* walls = maze.getWallRow(nextY);
+            const uint64_t* row = reached.data() + static_cast<size_t>(nextY + 1) * rowWords;
+            for (size_t word = span.first >> 6; word <= span.last >> 6; word++) {
+                uint64_t candidates = ~walls[word] & ~row[word] & rangeMask(word, span.first, span.last);
+                while (candidates) {
+                    markRun(nextY, word * 64 + __builtin_ctzll(candidates));
+                    candidates &= ~row[word];
+                }
+            }
+        }
+    }
+    return cells;
+}
+
+void PlacementMap::finish(const Maze& maze) {
+    // Nothing starts on the border or the ladder
+    for (size_t word = 0; word < rowWords; word++) {
+        bits[rowWords + word] = 0;
+        bits[static_cast<size_t>(height) * rowWords + word] = 0;
+    }
+    for (int y = 0; y < height; y++) {
+        uint64_t* row = bits.data() + static_cast<size_t>(y + 1) * rowWords;
+        row[0] &= ~(1ULL << 1);
+        row[width >> 6] &= ~(1ULL << (width & 63));
+    }
+    if (maze.isValidPosition(maze.getLadderX(), maze.getLadderY())) {
+        size_t bit = static_cast<size_t>(maze.getLadderX()) + 1;
+        bits[static_cast<size_t>(maze.getLadderY() + 1) * rowWords + (bit >> 6)] &= ~(1ULL << (bit & 63));
+    }
+    
+    blockRanks.assign(bits.size() / 8 + 1, 0);
+    cellCount = 0;
+    for (size_t word = 0; word < bits.size(); word++) {
+        if (word % 8 == 0) {
+            blockRanks[word / 8] = cellCount;
+        }
+        cellCount += __builtin_popcountll(bits[word]);
+    }
+}
+
+bool PlacementMap::contains(int x, int y) const {
+    if (x < 0 || x >= width || y < 0 || y >= height) {
+        return false;
+    }
+    size_t bit = static_cast<size_t>(x) + 1;
+    return (bits[static_cast<size_t>(y + 1) * rowWords + (bit >> 6)] >> (bit & 63)) & 1;
+}
+
+size_t PlacementMap::rank(int x, int y) const {
+    size_t position = static_cast<size_t>(y + 1) * rowWords * 64 + x + 1;
+    size_t word = position >> 6;
+    size_t count = blockRanks[word / 8];
+    for (size_t i = word & ~static_cast<size_t>(7); i < word; i++) {
+        count += __builtin_popcountll(bits[i]);
+    }
+    return count + __builtin_popcountll(bits[word] & ((1ULL << (position & 63)) - 1));
+}
+
+pair<int, int> PlacementMap::select(size_t index) const {
+    // Last block starting at or before the cell, then its words, then the bit
+    size_t block = upper_bound(blockRanks.begin(), blockRanks.end(), index) - blockRanks.begin() - 1;
+    size_t count = blockRanks[block];
+    size_t word = block * 8;
+    while (count + __builtin_popcountll(bits[word]) <= index) {
+        count += __builtin_popcountll(bits[word]);
+        word++;
+    }
+    uint64_t remaining = bits[word];
+    for (size_t i = count; i < index; i++) {
+        remaining &= remaining - 1;
+    }
+    size_t position = word * 64 + __builtin_ctzll(remaining);
+    size_t rowBits = rowWords * 64;
+    return {static_cast<int>(position % rowBits) - 1, static_cast<int>(position / rowBits) - 1};
+}
+
+size_t PlacementMap::sampleLimit() const {
+    // Rng::nextInt draws below an int
+    if (cellCount > static_cast<size_t>(INT_MAX)) {
+        throw runtime_error("Map too large to place objects");
+    }
+    return cellCount;
+}
+
+vector<pair<int, int>> PlacementMap::sampleApart(Rng& rng, int count, int minDistance) const {
+    size_t cells = sampleLimit();
+    vector<pair<int, int>> chosen;
+    vector<pair<size_t, size_t>> blocked;   // rank ranges [first, last) too close to a pick
+    vector<pair<size_t, size_t>> merged;
+    for (int i = 0; i < count; i++) {
+        sort(blocked.begin(), blocked.end());
+        merged.clear();
+        size_t blockedCells = 0;
+        for (const auto& range : blocked) {
+            if (!merged.empty() && range.first <= merged.back().second) {
+                blockedCells += max(range.second, merged.back().second) - merged.back().second;
+                merged.back().second = max(range.second, merged.back().second);
+            } else {
+                merged.push_back(range);
+                blockedCells += range.second - range.first;
+            }
+        }
+        if (blockedCells >= cells) {
+            throw runtime_error("Could not place heroes with required distance");
+        }
+        
+        // Draw among the free cells and step over the blocked ranges below it
+        size_t index = rng.nextInt(static_cast<int>(cells - blockedCells));
+        for (const auto& range : merged) {
+            if (range.first > index) {
+                break;
+            }
+            index += range.second - range.first;
+        }
+        pair<int, int> cell = select(index);
+        chosen.push_back(cell);
+        
+        int minX = max(cell.first - minDistance + 1, 0);
+        int maxX = min(cell.first + minDistance - 1, width - 1);
+        for (int y = max(cell.second - minDistance + 1, 0); y <= min(cell.second + minDistance - 1, height - 1); y++) {
+            size_t first = rank(minX, y);
+            size_t last = rank(maxX + 1, y);
+            if (first < last) {
+                blocked.push_back({first, last});
+            }
+        }
+    }
+    return chosen;
+}
+
+vector<pair<int, int>> PlacementMap::sample(Rng& rng, int count, const vector<pair<int, int>>& taken) const {
+    size_t cells = sampleLimit();
+    vector<size_t> skipped;
+    for (const auto& cell : taken) {
+        if (contains(cell.first, cell.second)) {
+            skipped.push_back(rank(cell.first, cell.second));
+        }
+    }
+    sort(skipped.begin(), skipped.end());
+    skipped.erase(unique(skipped.begin(), skipped.end()), skipped.end());
+    
+    size_t available = cells - skipped.size();
+    if (available < static_cast<size_t>(count)) {
+        throw runtime_error("Not enough free positions in maze");
+    }
+    
+    // Fisher-Yates over [0, available) that only stores the moved entries
+    unordered_map<size_t, size_t> moved;
+    auto valueAt = [&moved](size_t slot) {
+        auto found = moved.find(slot);
+        return found == moved.end() ? slot : found->second;
+    };
+    vector<pair<int, int>> chosen;
+    chosen.reserve(count);
+    for (int i = 0; i < count; i++) {
+        size_t slot = i + rng.nextInt(static_cast<int>(available - i));
+        size_t index = valueAt(slot);
+        moved[slot] = valueAt(i);
+        for (size_t rankTaken : skipped) {
+            if (rankTaken > index) {
+                break;
+            }
+            index++;
+        }
+        chosen.push_back(select(index));
+    }
+    return chosen;
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef PLACEMENTMAP_H
+#define PLACEMENTMAP_H
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+class Maze;
+class Rng;
+
+// The cells of a maze where objects may start: one connected part of the
+// map, without the border and the ladder. Everything placed in it can
+// reach everything else, so the heroes can always meet and get to the
+// keys. The part around the ladder is used when it has room for all
+// objects, the largest part of the map otherwise.
+//
+// The cells are a bitset in the padded row layout of Maze, found with a
+// span flood fill, plus a rank directory. Cells are drawn by index and
+// turned into positions with select, so nothing is ever enumerated or
+// retried per game.
+class PlacementMap {
+public:
+    // Shared map for a maze with this content, built on first use. Thread-safe.
+    static std::shared_ptr<const PlacementMap> get(const Maze& maze, size_t minimumCells);
+    
+    PlacementMap(const Maze& maze, size_t minimumCells);
+    
+    PlacementMap(const PlacementMap&) = delete;
+    PlacementMap& operator=(const PlacementMap&) = delete;
+    
+    size_t getCellCount() const { return cellCount; }
+    bool isLadderPart() const { return ladderPart; }
+    bool contains(int x, int y) const;
+    
+    // Cells before (x, y) in row-major order, x may be one past the last column
+    size_t rank(int x, int y) const;
+    // The cell with this rank, index < getCellCount()
+    std::pair<int, int> select(size_t index) const;
+    
+    // count cells, each at least minDistance from the others in x or y.
+    // Cells too close to earlier picks are skipped by rank instead of retried.
+    std::vector<std::pair<int, int>> sampleApart(Rng& rng, int count, int minDistance) const;
+    // count distinct cells not in taken, in random order
+    std::vector<std::pair<int, int>> sample(Rng& rng, int count, 
+                                            const std::vector<std::pair<int, int>>& taken) const;
+    
+private:
+    // Columns first..last of row y, as bit indices of the padded row
+    struct Span {
+        int y;
+        size_t first, last;
+    };
+    
+    int width, height;
+    size_t rowWords;
+    bool ladderPart;
+    size_t ladderCells;   // size of the part around the ladder, even when it was not used
+    size_t cellCount;
+    std::vector<uint64_t> bits;
+    std::vector<uint64_t> blockRanks;   // cells before every block of 8 words
+    
+    // Marks the part around (x, y) in reached, returns its size
+    size_t fill(const Maze& maze, int x, int y, std::vector<uint64_t>& reached, std::vector<Span>& stack) const;
+    void finish(const Maze& maze);
+    size_t sampleLimit() const;
+};
+
+#endif
\ No newline at end of file
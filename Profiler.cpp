@@ -0,0 +1,263 @@
+#include "Profiler.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+static const char* timerNames[PROFILE_TIMER_COUNT] = {
+    "processHeroTurn", "checkCollisions", "checkGameConditions", 
+    "updateWallDisappearing", "moveHeroesToLadder", "updateDisplay"
+};
+
+static const char* counterNames[PROFILE_COUNTER_COUNT] = {
+    "turns", "cells scanned", "moves evaluated", "blocked moves", "path expansions", "allocations"
+};
+
+ProfileStats::ProfileStats() {
+    fill(&calls[0], &calls[0] + PROFILE_TIMER_COUNT, 0);
+    fill(&nanoseconds[0], &nanoseconds[0] + PROFILE_TIMER_COUNT, 0);
+    fill(&histogram[0][0], &histogram[0][0] + PROFILE_TIMER_COUNT * PROFILE_HISTOGRAM_BUCKETS, 0);
+    fill(&counters[0], &counters[0] + PROFILE_COUNTER_COUNT, 0);
+}
+
+uint64_t ProfileStats::percentileNanoseconds(ProfileTimer timer, double percentile) const {
+    int index = static_cast<int>(timer);
+    uint64_t wanted = static_cast<uint64_t>(calls[index] * percentile / 100.0);
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < PROFILE_HISTOGRAM_BUCKETS; bucket++) {
+        seen += histogram[index][bucket];
+        if (seen > 0 && seen >= wanted) {
+            return 2ULL << bucket;
+        }
+    }
+    return 0;
+}
+
+// Only the owning thread writes its slots, relaxed atomics just let
+// snapshot() read them while the game is running
+struct ThreadProfile {
+    atomic<uint64_t> calls[PROFILE_TIMER_COUNT];
+    atomic<uint64_t> nanoseconds[PROFILE_TIMER_COUNT];
+    atomic<uint64_t> histogram[PROFILE_TIMER_COUNT][PROFILE_HISTOGRAM_BUCKETS];
+    atomic<uint64_t> counters[PROFILE_COUNTER_COUNT];
+    
+    ThreadProfile();
+    ~ThreadProfile();
+    
+    void addTo(ProfileStats& stats) const;
+    void clear();
+};
+
+static void bump(atomic<uint64_t>& slot, uint64_t amount) {
+    slot.store(slot.load(memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+// Registry of live threads plus the totals of threads that have exited
+static mutex registryMutex;
+static vector<ThreadProfile*>& liveProfiles() {
+    static vector<ThreadProfile*>* profiles = new vector<ThreadProfile*>();
+    return *profiles;
+}
+static ProfileStats& retiredStats() {
+    static ProfileStats* stats = new ProfileStats();
+    return *stats;
+}
+static string reportFile = "maze_profile.txt";
+
+ThreadProfile::ThreadProfile() {
+    clear();
+    lock_guard<mutex> lock(registryMutex);
+    liveProfiles().push_back(this);
+}
+
+ThreadProfile::~ThreadProfile() {
+    lock_guard<mutex> lock(registryMutex);
+    addTo(retiredStats());
+    vector<ThreadProfile*>& profiles = liveProfiles();
+    profiles.erase(remove(profiles.begin(), profiles.end(), this), profiles.end());
+}
+
+void ThreadProfile::addTo(ProfileStats& stats) const {
+    for (int t = 0; t < PROFILE_TIMER_COUNT; t++) {
+        stats.calls[t] += calls[t].load(memory_order_relaxed);
+        stats.nanoseconds[t] += nanoseconds[t].load(memory_order_relaxed);
+        for (int b = 0; b < PROFILE_HISTOGRAM_BUCKETS; b++) {
+            stats.histogram[t][b] += histogram[t][b].load(memory_order_relaxed);
+        }
+    }
+    for (int c = 0; c < PROFILE_COUNTER_COUNT; c++) {
+        stats.counters[c] += counters[c].load(memory_order_relaxed);
+    }
+}
+
+void ThreadProfile::clear() {
+    for (int t = 0; t < PROFILE_TIMER_COUNT; t++) {
+        calls[t].store(0, memory_order_relaxed);
+        nanoseconds[t].store(0, memory_order_relaxed);
+        for (int b = 0; b < PROFILE_HISTOGRAM_BUCKETS; b++) {
+            histogram[t][b].store(0, memory_order_relaxed);
+        }
+    }
+    for (int c = 0; c < PROFILE_COUNTER_COUNT; c++) {
+        counters[c].store(0, memory_order_relaxed);
+    }
+}
+
+static ThreadProfile& localProfile() {
+    static thread_local ThreadProfile profile;
+    return profile;
+}
+
+// Plain counter so operator new can bump it without running constructors
+static thread_local uint64_t allocationsOnThread = 0;
+
+#ifndef MAZE_NO_PROFILE
+void* operator new(size_t size) {
+    allocationsOnThread++;
+    void* memory = malloc(size ? size : 1);
+    if (!memory) {
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    free(memory);
+}
+#endif
+
+void Profiler::addCounter(ProfileCounter counter, uint64_t amount) {
+    bump(localProfile().counters[static_cast<int>(counter)], amount);
+}
+
+void Profiler::addTime(ProfileTimer timer, uint64_t nanoseconds) {
+    int index = static_cast<int>(timer);
+    ThreadProfile& profile = localProfile();
+    bump(profile.calls[index], 1);
+    bump(profile.nanoseconds[index], nanoseconds);
+    
+    // floor(log2), calls under a nanosecond go to the first bucket
+    int bucket = nanoseconds > 1 ? 63 - __builtin_clzll(nanoseconds) : 0;
+    bump(profile.histogram[index][min(bucket, PROFILE_HISTOGRAM_BUCKETS - 1)], 1);
+}
+
+uint64_t Profiler::threadAllocations() {
+    return allocationsOnThread;
+}
+
+ProfileStats Profiler::snapshot() {
+    lock_guard<mutex> lock(registryMutex);
+    ProfileStats stats = retiredStats();
+    for (const ThreadProfile* profile : liveProfiles()) {
+        profile->addTo(stats);
+    }
+    return stats;
+}
+
+void Profiler::reset() {
+    lock_guard<mutex> lock(registryMutex);
+    retiredStats() = ProfileStats();
+    for (ThreadProfile* profile : liveProfiles()) {
+        profile->clear();
+    }
+}
+
+void Profiler::report(ostream& out) {
+    if (!enabled) {
+        out << "Profiling was compiled out (MAZE_NO_PROFILE)" << endl;
+        return;
+    }
+    
+    ProfileStats stats = snapshot();
+    uint64_t turns = stats.counters[static_cast<int>(ProfileCounter::TURNS)];
+    
+    ios::fmtflags oldFlags = out.flags();
+    streamsize oldPrecision = out.precision();
+    out << fixed << setprecision(1);
+    
+    out << "Timers:                    calls    total ms     mean ns      p50 ns      p99 ns" << endl;
+    for (int t = 0; t < PROFILE_TIMER_COUNT; t++) {
+        if (stats.calls[t] == 0) {
+            continue;
+        }
+        ProfileTimer timer = static_cast<ProfileTimer>(t);
+        out << "  " << left << setw(24) << timerNames[t] << right
+            << setw(10) << stats.calls[t] 
+            << setw(12) << stats.nanoseconds[t] / 1e6
+            << setw(12) << static_cast<double>(stats.nanoseconds[t]) / stats.calls[t]
+            << setw(12) << "<" + to_string(stats.percentileNanoseconds(timer, 50))
+            << setw(12) << "<" + to_string(stats.percentileNanoseconds(timer, 99)) << endl;
+    }
+    
+    out << "Counters:                  total    per turn" << endl;
+    for (int c = 0; c < PROFILE_COUNTER_COUNT; c++) {
+        out << "  " << left << setw(24) << counterNames[c] << right
+            << setw(10) << stats.counters[c]
+            << setw(12) << (turns > 0 ? static_cast<double>(stats.counters[c]) / turns : 0.0) << endl;
+    }
+    
+    // Log2 latency histograms, one line per non-empty bucket
+    for (int t = 0; t < PROFILE_TIMER_COUNT; t++) {
+        if (stats.calls[t] == 0) {
+            continue;
+        }
+        out << "Histogram " << timerNames[t] << ":" << endl;
+        for (int b = 0; b < PROFILE_HISTOGRAM_BUCKETS; b++) {
+            uint64_t count = stats.histogram[t][b];
+            if (count == 0) {
+                continue;
+            }
+            int width = static_cast<int>(count * 50 / stats.calls[t]);
+            out << "  " << setw(12) << (1ULL << b) << " ns " << setw(10) << count << " " 
+                << string(max(width, 1), '#') << endl;
+        }
+    }
+    
+    out.flags(oldFlags);
+    out.precision(oldPrecision);
+}
+
+void Profiler::setReportFile(const string& filename) {
+    lock_guard<mutex> lock(registryMutex);
+    reportFile = filename;
+}
+
+void Profiler::reportToFile() {
+    string filename;
+    {
+        lock_guard<mutex> lock(registryMutex);
+        filename = reportFile;
+    }
+    
+    if (filename == "-") {
+        report(cerr);
+        return;
+    }
+    ofstream out(filename);
+    if (!out.is_open()) {
+        throw runtime_error("Cannot write profile to " + filename);
+    }
+    report(out);
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Built-in instrumentation for the simulation hot paths: scoped timers
+// with log2 latency histograms and event counters. Every thread records
+// into its own slots, so batch workers never contend.
+// Build with -DMAZE_NO_PROFILE to compile all of it out.
+
+enum class ProfileTimer {
+    HERO_TURN,
+    COLLISIONS,
+    GAME_CONDITIONS,
+    WALL_DISAPPEARING,
+    MOVE_TO_LADDER,
+    DISPLAY
+};
+
+const int PROFILE_TIMER_COUNT = 6;
+
+enum class ProfileCounter {
+    TURNS,
+    CELLS_SCANNED,
+    MOVES_EVALUATED,
+    BLOCKED_MOVES,
+    PATH_EXPANSIONS,
+    ALLOCATIONS
+};
+
+const int PROFILE_COUNTER_COUNT = 6;
+
+// Bucket i holds calls that took [2^i, 2^(i+1)) nanoseconds
+const int PROFILE_HISTOGRAM_BUCKETS = 40;
+
+// Plain totals, merged from all threads
+struct ProfileStats {
+    uint64_t calls[PROFILE_TIMER_COUNT];
+    uint64_t nanoseconds[PROFILE_TIMER_COUNT];
+    uint64_t histogram[PROFILE_TIMER_COUNT][PROFILE_HISTOGRAM_BUCKETS];
+    uint64_t counters[PROFILE_COUNTER_COUNT];
+    
+    ProfileStats();
+    
+    // Latency below which the given percentage of calls finished,
+    // rounded up to the histogram bucket boundary
+    uint64_t percentileNanoseconds(ProfileTimer timer, double percentile) const;
+};
+
+class Profiler {
+public:
+#ifdef MAZE_NO_PROFILE
+    static const bool enabled = false;
+#else
+    static const bool enabled = true;
+#endif
+    
+    static void addCounter(ProfileCounter counter, uint64_t amount);
+    static void addTime(ProfileTimer timer, uint64_t nanoseconds);
+    
+    // Allocations made by the calling thread so far
+    static uint64_t threadAllocations();
+    
+    // Totals of every thread, live and finished
+    static ProfileStats snapshot();
+    static void reset();
+    
+    static void report(std::ostream& out);
+    
+    // Where reportToFile writes, "-" means stderr
+    static void setReportFile(const std::string& filename);
+    static void reportToFile();
+};
+
+// Times the enclosing scope
+class ScopedTimer {
+public:
+    explicit ScopedTimer(ProfileTimer profileTimer) 
+        : timer(profileTimer), start(std::chrono::steady_clock::now()) {}
+    
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Profiler::addTime(timer, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+    
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+    
+private:
+    ProfileTimer timer;
+    std::chrono::steady_clock::time_point start;
+};
+
+#ifdef MAZE_NO_PROFILE
+#define PROFILE_SCOPE(timer) ((void)0)
+#define PROFILE_COUNT(counter, amount) ((void)0)
+#else
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(timer) ScopedTimer PROFILE_CONCAT(profileScope, __LINE__)(timer)
+#define PROFILE_COUNT(counter, amount) Profiler::addCounter(counter, amount)
+#endif
+
+#endif
\ No newline at end of file
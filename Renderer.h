@@ -0,0 +1,52 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+class Maze;
+
+// A single object drawn on top of the maze
+struct Sprite {
+    int x, y;
+    char symbol;
+    int colorPair;
+};
+
+// Everything a renderer needs to draw one turn, filled in by Game
+struct RenderFrame {
+    int turn;
+    std::vector<Sprite> sprites;
+    std::string status;
+    
+    // Maze cells that changed since the previous frame (removed walls)
+    std::vector<std::pair<int, int>> changedCells;
+};
+
+class Renderer {
+public:
+    virtual ~Renderer() {}
+    
+    virtual void init(const Maze* maze) {}
+    virtual void drawFrame(const Maze* maze, const RenderFrame& frame) = 0;
+    virtual void logMessage(const std::string& message) {}
+    virtual void showResult(const Maze* maze, bool won) {}
+    
+    // Next pending key press, or -1. Polled by Game::run on the render thread.
+    virtual int readKey() { return -1; }
+    // Becomes readable when readKey has something, -1 if keys never arrive
+    virtual int getInputFd() const { return -1; }
+    
+    // Headless renderers skip frame building entirely
+    virtual bool wantsFrames() const { return true; }
+};
+
+// Draws nothing, used for headless simulation
+class NullRenderer : public Renderer {
+public:
+    void drawFrame(const Maze* maze, const RenderFrame& frame) override {}
+    bool wantsFrames() const override { return false; }
+};
+
+#endif
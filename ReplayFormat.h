@@ -0,0 +1,94 @@
+#ifndef REPLAYFORMAT_H
+#define REPLAYFORMAT_H
+
+#include <cstdint>
+#include <vector>
+
+// Layout of a game replay (.mzr), written by ReplayRecorder and read by
+// ReplayPlayer. All fields are little-endian.
+//
+//   header | initial wall rows | records | keyframe index
+//
+// Record t takes the game from the state after turn t - 1 to the state
+// after turn t. Every keyframeInterval turns the record is a keyframe
+// holding the full state instead of a delta, so any turn can be reached
+// by jumping to the keyframe before it and applying at most
+// keyframeInterval - 1 deltas.
+//
+// Keyframe: 'K', turn, phase, outcome, the walls, then every entity as
+//   x, y, flags. The walls are either 1 + the wall rows (height * rowWords
+//   words), or 0 + the file offset of the last wall rows, the index of the
+//   first keyframe after them and the walls removed since the previous
+//   keyframe, written like in a delta. The walls of keyframe k are the
+//   last rows with the removals of that first keyframe up to k applied.
+//   Rows are only written again once those removals would take more
+//   space than the rows, so seeking reads at most about one copy of the
+//   walls whatever the dissolve rate.
+// Delta: 'D', change flags byte, the number of changed entities and for
+//   each one the gap to the previous changed entity index, zigzag dx, dy
+//   and flags; phase and outcome if REPLAY_PHASE_CHANGED; if
+//   REPLAY_WALLS_CHANGED the number of removed walls and each cell index
+//   (y * width + x) as a zigzag difference from the previous one.
+//
+// Entities are numbered heroes first, then keys, then traps, with the
+// counts taken from the header.
+//
+// Numbers in records are LEB128 varints unless noted as bytes.
+const char REPLAY_MAGIC[4] = {'M', 'Z', 'R', '2'};
+const uint32_t REPLAY_VERSION = 3;
+
+struct ReplayHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    int32_t ladderX;
+    int32_t ladderY;
+    uint32_t rowWords;
+    uint32_t keyframeInterval;
+    uint64_t seed;
+    uint64_t wallsOffset;
+    uint64_t recordsOffset;
+    uint64_t indexOffset;     // one uint64 record offset per keyframe, 0 until finished
+    uint32_t turnCount;
+    uint32_t keyframeCount;
+    uint32_t heroCount;
+    uint32_t keyCount;
+    uint32_t trapCount;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ReplayHeader) == 88, "replay header must stay 88 bytes");
+
+// Entity flags
+const uint8_t REPLAY_HAS_KEY = 1;     // heroes
+const uint8_t REPLAY_TRAPPED = 2;
+const uint8_t REPLAY_ACTIVE = 1;      // keys and traps
+const uint8_t REPLAY_VISIBLE = 2;
+const uint8_t REPLAY_CAGE = 4;
+
+// Delta change flags
+const uint8_t REPLAY_PHASE_CHANGED = 1;
+const uint8_t REPLAY_WALLS_CHANGED = 2;
+
+enum ReplayOutcome {
+    REPLAY_RUNNING,
+    REPLAY_WON,
+    REPLAY_LOST
+};
+
+struct ReplayEntityState {
+    int32_t x;
+    int32_t y;
+    uint8_t flags;
+};
+
+// Everything on screen apart from the walls
+struct ReplayState {
+    int turn;
+    uint8_t phase;      // GamePhase
+    uint8_t outcome;    // ReplayOutcome
+    std::vector<ReplayEntityState> entities;
+};
+
+#endif
\ No newline at end of file
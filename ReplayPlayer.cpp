@@ -0,0 +1,300 @@
+#include "ReplayPlayer.h"
+#include "Game.h"
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+ReplayPlayer::ReplayPlayer(const string& filename) 
+    : file(filename), turnCount(0), maze(1, 1), position(0) {
+    state.turn = 0;
+    state.phase = 0;
+    state.outcome = REPLAY_RUNNING;
+    if (file.getSize() < sizeof(header)) {
+        throw runtime_error("Not a replay file: " + filename);
+    }
+    memcpy(&header, file.getData(), sizeof(header));
+    if (memcmp(header.magic, REPLAY_MAGIC, sizeof(header.magic)) != 0) {
+        throw runtime_error("Not a replay file: " + filename);
+    }
+    if (header.version != REPLAY_VERSION) {
+        throw runtime_error("Unsupported replay version in " + filename);
+    }
+    
+    uint64_t rowBytes = static_cast<uint64_t>(header.rowWords) * sizeof(uint64_t);
+    if (header.width < 1 || header.height < 1 || header.keyframeInterval < 1 || header.keyframeInterval > INT_MAX ||
+        header.rowWords != (header.width + 2 + 63) / 64 ||
+        header.recordsOffset != header.wallsOffset + rowBytes * header.height ||
+        header.recordsOffset > file.getSize() || header.heroCount < 1 ||
+        static_cast<uint64_t>(header.heroCount) + header.keyCount + header.trapCount > file.getSize()) {
+        throw runtime_error("Corrupt replay file: " + filename);
+    }
+    state.entities.assign(header.heroCount + header.keyCount + header.trapCount, {0, 0, 0});
+    
+    maze = Maze(header.width, header.height);
+    maze.setLadder(header.ladderX, header.ladderY);
+    
+    if (header.indexOffset != 0) {
+        // seek indexes the keyframes with turn / interval for every turn up to turnCount
+        uint64_t indexBytes = static_cast<uint64_t>(header.keyframeCount) * sizeof(uint64_t);
+        if (header.keyframeCount == 0 || header.indexOffset > file.getSize() ||
+            indexBytes > file.getSize() - header.indexOffset || header.turnCount > INT_MAX ||
+            header.turnCount / header.keyframeInterval >= header.keyframeCount) {
+            throw runtime_error("Corrupt replay file: " + filename);
+        }
+        keyframeOffsets.resize(header.keyframeCount);
+        memcpy(keyframeOffsets.data(), file.getData() + header.indexOffset, indexBytes);
+        for (uint64_t offset : keyframeOffsets) {
+            if (offset < header.recordsOffset || offset >= file.getSize()) {
+                throw runtime_error("Corrupt replay file: " + filename);
+            }
+        }
+        turnCount = header.turnCount;
+    } else {
+        // The recording was not finished, rebuild the index
+        scanRecords();
+    }
+    
+    seek(0);
+    changedCells.clear();
+}
+
+void ReplayPlayer::scanRecords() {
+    position = header.recordsOffset;
+    try {
+        while (position < file.getSize()) {
+            size_t start = position;
+            if (file.getData()[start] == 'K') {
+                keyframeOffsets.push_back(start);
+            }
+            // Only the offsets are needed, seek(0) loads the walls afterwards
+            readRecord(true);
+            turnCount = state.turn;
+        }
+    } catch (const runtime_error&) {
+        // A partly written last record ends the replay
+    }
+    if (keyframeOffsets.empty()) {
+        throw runtime_error("Replay file has no turns");
+    }
+}
+
+bool ReplayPlayer::next() {
+    if (state.turn >= turnCount) {
+        return false;
+    }
+    readRecord(true);
+    return true;
+}
+
+void ReplayPlayer::seek(int turn) {
+    turn = max(0, min(turn, turnCount));
+    
+    // Jump unless the keyframe is behind the current turn anyway
+    int interval = header.keyframeInterval;
+    if (position == 0 || turn < state.turn || (turn / interval) * interval > state.turn) {
+        position = keyframeOffsets[turn / interval];
+        readRecord(false);
+    }
+    while (state.turn < turn) {
+        readRecord(true);
+    }
+}
+
+void ReplayPlayer::readRecord(bool sequential) {
+    uint8_t tag = readByte();
+    if (tag == 'K') {
+        state.turn = readVarint();
+        state.phase = readByte();
+        state.outcome = readByte();
+        readKeyframeWalls(sequential);
+        for (auto& entity : state.entities) {
+            entity.x = static_cast<int32_t>(readVarint());
+            entity.y = static_cast<int32_t>(readVarint());
+            entity.flags = readByte();
+        }
+    } else if (tag == 'D') {
+        uint8_t changes = readByte();
+        uint64_t changedCount = readVarint();
+        uint64_t next = 0;
+        for (uint64_t i = 0; i < changedCount; i++) {
+            uint64_t entity = next + readVarint();
+            if (entity >= state.entities.size()) {
+                throw runtime_error("Corrupt replay file");
+            }
+            next = entity + 1;
+            state.entities[entity].x += static_cast<int32_t>(readSigned());
+            state.entities[entity].y += static_cast<int32_t>(readSigned());
+            state.entities[entity].flags = readByte();
+        }
+        if (changes & REPLAY_PHASE_CHANGED) {
+            state.phase = readByte();
+            state.outcome = readByte();
+        }
+        if (changes & REPLAY_WALLS_CHANGED) {
+            readRemovedWalls();
+        }
+        state.turn++;
+    } else {
+        throw runtime_error("Corrupt replay file");
+    }
+}
+
+void ReplayPlayer::readKeyframeWalls(bool sequential) {
+    if (readByte()) {
+        uint64_t wallsOffset = position;
+        position += static_cast<uint64_t>(header.rowWords) * sizeof(uint64_t) * header.height;
+        if (position > file.getSize()) {
+            throw runtime_error("Corrupt replay file");
+        }
+        loadWalls(wallsOffset);
+        return;
+    }
+    
+    // Playing forward only the walls removed during this turn are missing,
+    // the rest of the list is already applied
+    uint64_t wallsOffset = readVarint();
+    uint64_t firstKeyframe = readVarint();
+    if (sequential) {
+        readRemovedWalls();
+        return;
+    }
+    
+    // The last rows, then the removals of every keyframe since them
+    uint64_t keyframe = state.turn / header.keyframeInterval;
+    if (firstKeyframe > keyframe || keyframe >= keyframeOffsets.size()) {
+        throw runtime_error("Corrupt replay file");
+    }
+    size_t listPosition = position;
+    loadWalls(wallsOffset);
+    for (uint64_t i = firstKeyframe; i < keyframe; i++) {
+        position = keyframeOffsets[i];
+        if (readByte() != 'K') {
+            throw runtime_error("Corrupt replay file");
+        }
+        readVarint();
+        readByte();
+        readByte();
+        if (readByte() != 0) {
+            throw runtime_error("Corrupt replay file");
+        }
+        readVarint();
+        readVarint();
+        readRemovedWalls();
+    }
+    position = listPosition;
+    readRemovedWalls();
+}
+
+void ReplayPlayer::readRemovedWalls() {
+    uint64_t count = readVarint();
+    int64_t cell = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        cell += readSigned();
+        int x = static_cast<int>(cell % header.width);
+        int y = static_cast<int>(cell / header.width);
+        if (maze.isValidPosition(x, y) && maze.isWall(x, y)) {
+            maze.removeWall(x, y);
+            changedCells.push_back({x, y});
+        }
+    }
+}
+
+void ReplayPlayer::loadWalls(uint64_t offset) {
+    uint64_t rowBytes = static_cast<uint64_t>(header.rowWords) * sizeof(uint64_t);
+    if (offset < header.wallsOffset || offset + rowBytes * header.height > file.getSize()) {
+        throw runtime_error("Corrupt replay file");
+    }
+    
+    // Only rewrite rows that differ and remember which cells changed
+    vector<uint64_t> row(header.rowWords);
+    for (uint32_t y = 0; y < header.height; y++) {
+        memcpy(row.data(), file.getData() + offset + y * rowBytes, rowBytes);
+        const uint64_t* current = maze.getWallRow(y);
+        bool differs = false;
+        for (uint32_t i = 0; i < header.rowWords; i++) {
+            uint64_t changed = current[i] ^ row[i];
+            while (changed) {
+                int x = i * 64 + __builtin_ctzll(changed) - 1;
+                if (x >= 0 && x < static_cast<int>(header.width)) {
+                    changedCells.push_back({x, static_cast<int>(y)});
+                    differs = true;
+                }
+                changed &= changed - 1;
+            }
+        }
+        if (differs) {
+            maze.setWallRow(y, row.data());
+        }
+    }
+}
+
+uint8_t ReplayPlayer::readByte() {
+    if (position >= file.getSize()) {
+        throw runtime_error("Corrupt replay file");
+    }
+    return static_cast<uint8_t>(file.getData()[position++]);
+}
+
+uint64_t ReplayPlayer::readVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = readByte();
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw runtime_error("Corrupt replay file");
+}
+
+int64_t ReplayPlayer::readSigned() {
+    uint64_t value = readVarint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+RenderFrame ReplayPlayer::buildFrame() {
+    // Same sprites and colors as Game::buildFrame
+    RenderFrame frame;
+    frame.turn = state.turn;
+    
+    size_t firstKey = header.heroCount;
+    size_t firstTrap = firstKey + header.keyCount;
+    for (size_t i = firstKey; i < firstTrap; i++) {
+        const ReplayEntityState& key = state.entities[i];
+        if (key.flags & REPLAY_ACTIVE) {
+            frame.sprites.push_back({key.x, key.y, 'K', 2});
+        }
+    }
+    
+    for (size_t i = firstTrap; i < state.entities.size(); i++) {
+        const ReplayEntityState& trap = state.entities[i];
+        if ((trap.flags & REPLAY_ACTIVE) && !(trap.flags & REPLAY_CAGE)) {
+            frame.sprites.push_back({trap.x, trap.y, 'T', 4});
+        }
+    }
+    for (size_t i = firstTrap; i < state.entities.size(); i++) {
+        const ReplayEntityState& cage = state.entities[i];
+        if ((cage.flags & REPLAY_CAGE) && (cage.flags & REPLAY_VISIBLE)) {
+            frame.sprites.push_back({cage.x, cage.y, 'C', 4});
+        }
+    }
+    
+    for (size_t i = 0; i < firstKey; i++) {
+        const ReplayEntityState& hero = state.entities[i];
+        if (!(hero.flags & REPLAY_TRAPPED)) {
+            frame.sprites.push_back({hero.x, hero.y, Game::heroSymbol(i), 1});
+        }
+    }
+    
+    if (state.phase == static_cast<uint8_t>(GamePhase::WALLS_DISAPPEARING)) {
+        frame.status = "Heroes found! Walls disappearing...";
+    } else if (state.phase == static_cast<uint8_t>(GamePhase::MOVING_TO_LADDER)) {
+        frame.status = "Moving to the ladder...";
+    }
+    
+    frame.changedCells.swap(changedCells);
+    changedCells.clear();
+    return frame;
+}
\ No newline at end of file
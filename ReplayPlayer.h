@@ -0,0 +1,54 @@
+#ifndef REPLAYPLAYER_H
+#define REPLAYPLAYER_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include "ReplayFormat.h"
+#include "MappedFile.h"
+#include "Maze.h"
+#include "Renderer.h"
+
+// Plays back a replay file without simulating the game. seek() jumps to
+// the keyframe before the wanted turn and applies the deltas after it.
+class ReplayPlayer {
+public:
+    explicit ReplayPlayer(const std::string& filename);
+    
+    int getTurnCount() const { return turnCount; }
+    int getKeyframeInterval() const { return header.keyframeInterval; }
+    uint64_t getSeed() const { return header.seed; }
+    int getTurn() const { return state.turn; }
+    const ReplayState& getState() const { return state; }
+    const Maze& getMaze() const { return maze; }
+    
+    // Advances one turn, false at the end of the replay
+    bool next();
+    // Clamped to [0, getTurnCount()]
+    void seek(int turn);
+    
+    // Sprites and status of the current turn. changedCells lists every
+    // wall that changed since the previous call.
+    RenderFrame buildFrame();
+    
+private:
+    MappedFile file;
+    ReplayHeader header;
+    std::vector<uint64_t> keyframeOffsets;
+    int turnCount;
+    Maze maze;
+    ReplayState state;
+    size_t position;      // offset of the next record
+    std::vector<std::pair<int, int>> changedCells;
+    
+    void scanRecords();
+    void readRecord(bool sequential);
+    void readKeyframeWalls(bool sequential);
+    void loadWalls(uint64_t offset);
+    void readRemovedWalls();
+    uint8_t readByte();
+    uint64_t readVarint();
+    int64_t readSigned();
+};
+
+#endif
\ No newline at end of file
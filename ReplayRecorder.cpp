@@ -0,0 +1,209 @@
+#include "ReplayRecorder.h"
+#include "Maze.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+// Records are collected in memory and written in large chunks
+static const size_t FLUSH_BYTES = 64 * 1024;
+
+ReplayRecorder::ReplayRecorder(const string& filename, const Maze* maze, uint64_t seed, int keyframeInterval,
+                               int heroCount, int keyCount, int trapCount) 
+    : bufferOffset(0), turnCount(0), firstRemovalKeyframe(0), removalBytes(0), finished(false) {
+    if (keyframeInterval < 1) {
+        throw runtime_error("Keyframe interval must be at least 1");
+    }
+    if (heroCount < 0 || keyCount < 0 || trapCount < 0) {
+        throw runtime_error("Entity counts can't be negative");
+    }
+    
+    file.open(filename, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        throw runtime_error("Cannot write replay file: " + filename);
+    }
+    
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+    header.version = REPLAY_VERSION;
+    header.width = maze->getWidth();
+    header.height = maze->getHeight();
+    header.ladderX = maze->getLadderX();
+    header.ladderY = maze->getLadderY();
+    header.rowWords = maze->getRowWords();
+    header.keyframeInterval = keyframeInterval;
+    header.seed = seed;
+    header.heroCount = heroCount;
+    header.keyCount = keyCount;
+    header.trapCount = trapCount;
+    header.wallsOffset = sizeof(header);
+    
+    uint64_t rowBytes = static_cast<uint64_t>(header.rowWords) * sizeof(uint64_t);
+    header.recordsOffset = header.wallsOffset + rowBytes * header.height;
+    lastWallsOffset = header.wallsOffset;
+    
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int y = 0; y < maze->getHeight(); y++) {
+        file.write(reinterpret_cast<const char*>(maze->getWallRow(y)), rowBytes);
+    }
+    bufferOffset = header.recordsOffset;
+}
+
+ReplayRecorder::~ReplayRecorder() {
+    try {
+        finish();
+    } catch (const exception&) {
+        // Nothing sensible to do while destroying, the file stays unfinished
+    }
+}
+
+void ReplayRecorder::recordTurn(const ReplayState& state, const vector<pair<int, int>>& removedWalls, 
+                                const Maze* maze) {
+    if (finished) {
+        return;
+    }
+    if (state.entities.size() != static_cast<size_t>(header.heroCount) + header.keyCount + header.trapCount) {
+        throw runtime_error("Replay state does not match the recorded entity counts");
+    }
+    size_t firstRemoved = removedCells.size();
+    for (const auto& wall : removedWalls) {
+        removedCells.push_back(static_cast<int64_t>(wall.second) * header.width + wall.first);
+    }
+    
+    if (state.turn % header.keyframeInterval == 0) {
+        writeKeyframe(state, maze);
+    } else {
+        writeDelta(state, firstRemoved);
+    }
+    previous = state;
+    turnCount = state.turn;
+    
+    if (buffer.size() >= FLUSH_BYTES) {
+        flushBuffer();
+    }
+}
+
+void ReplayRecorder::writeKeyframe(const ReplayState& state, const Maze* maze) {
+    keyframeOffsets.push_back(bufferOffset + buffer.size());
+    
+    buffer.push_back('K');
+    putVarint(state.turn);
+    buffer.push_back(static_cast<char>(state.phase));
+    buffer.push_back(static_cast<char>(state.outcome));
+    
+    // Refer to the last rows unless the removals since them outgrow a new copy
+    size_t listStart = buffer.size();
+    buffer.push_back(0);
+    putVarint(lastWallsOffset);
+    putVarint(firstRemovalKeyframe);
+    putCells(0);
+    uint64_t rowBytes = static_cast<uint64_t>(header.rowWords) * sizeof(uint64_t);
+    removalBytes += buffer.size() - listStart;
+    if (removalBytes > rowBytes * header.height) {
+        buffer.resize(listStart);
+        buffer.push_back(1);
+        lastWallsOffset = bufferOffset + buffer.size();
+        for (int y = 0; y < maze->getHeight(); y++) {
+            buffer.append(reinterpret_cast<const char*>(maze->getWallRow(y)), rowBytes);
+        }
+        firstRemovalKeyframe = keyframeOffsets.size();
+        removalBytes = 0;
+    }
+    removedCells.clear();
+    
+    for (const auto& entity : state.entities) {
+        putVarint(static_cast<uint32_t>(entity.x));
+        putVarint(static_cast<uint32_t>(entity.y));
+        buffer.push_back(static_cast<char>(entity.flags));
+    }
+}
+
+void ReplayRecorder::writeDelta(const ReplayState& state, size_t firstRemoved) {
+    changedEntities.clear();
+    for (size_t i = 0; i < state.entities.size(); i++) {
+        const ReplayEntityState& now = state.entities[i];
+        const ReplayEntityState& before = previous.entities[i];
+        if (now.x != before.x || now.y != before.y || now.flags != before.flags) {
+            changedEntities.push_back(i);
+        }
+    }
+    
+    uint8_t changes = 0;
+    if (state.phase != previous.phase || state.outcome != previous.outcome) {
+        changes |= REPLAY_PHASE_CHANGED;
+    }
+    if (firstRemoved < removedCells.size()) {
+        changes |= REPLAY_WALLS_CHANGED;
+    }
+    
+    buffer.push_back('D');
+    buffer.push_back(static_cast<char>(changes));
+    putVarint(changedEntities.size());
+    int next = 0;
+    for (int i : changedEntities) {
+        putVarint(i - next);
+        next = i + 1;
+        putSigned(state.entities[i].x - previous.entities[i].x);
+        putSigned(state.entities[i].y - previous.entities[i].y);
+        buffer.push_back(static_cast<char>(state.entities[i].flags));
+    }
+    if (changes & REPLAY_PHASE_CHANGED) {
+        buffer.push_back(static_cast<char>(state.phase));
+        buffer.push_back(static_cast<char>(state.outcome));
+    }
+    if (changes & REPLAY_WALLS_CHANGED) {
+        putCells(firstRemoved);
+    }
+}
+
+// Count and zigzag differences of removedCells from first on
+void ReplayRecorder::putCells(size_t first) {
+    putVarint(removedCells.size() - first);
+    int64_t last = 0;
+    for (size_t i = first; i < removedCells.size(); i++) {
+        putSigned(removedCells[i] - last);
+        last = removedCells[i];
+    }
+}
+
+void ReplayRecorder::putVarint(uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+void ReplayRecorder::putSigned(int64_t value) {
+    // Zigzag: small negative numbers stay small
+    putVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void ReplayRecorder::flushBuffer() {
+    file.write(buffer.data(), buffer.size());
+    bufferOffset += buffer.size();
+    buffer.clear();
+    if (!file) {
+        throw runtime_error("Cannot write replay file");
+    }
+}
+
+void ReplayRecorder::finish() {
+    if (finished) {
+        return;
+    }
+    finished = true;
+    flushBuffer();
+    
+    header.indexOffset = bufferOffset;
+    header.turnCount = turnCount;
+    header.keyframeCount = keyframeOffsets.size();
+    file.write(reinterpret_cast<const char*>(keyframeOffsets.data()), keyframeOffsets.size() * sizeof(uint64_t));
+    
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+    if (!file) {
+        throw runtime_error("Cannot write replay file");
+    }
+}
\ No newline at end of file
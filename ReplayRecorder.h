@@ -0,0 +1,57 @@
+#ifndef REPLAYRECORDER_H
+#define REPLAYRECORDER_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <utility>
+#include "ReplayFormat.h"
+
+class Maze;
+
+// Writes a game as a replay file (see ReplayFormat.h). The caller passes
+// the state after every turn, starting with turn 0 right after setup,
+// with the entities in the order given by ReplayFormat.h.
+class ReplayRecorder {
+public:
+    ReplayRecorder(const std::string& filename, const Maze* maze, uint64_t seed, int keyframeInterval,
+                   int heroCount, int keyCount, int trapCount);
+    ~ReplayRecorder();
+    
+    ReplayRecorder(const ReplayRecorder&) = delete;
+    ReplayRecorder& operator=(const ReplayRecorder&) = delete;
+    
+    // removedWalls are the walls removed during this turn
+    void recordTurn(const ReplayState& state, const std::vector<std::pair<int, int>>& removedWalls, 
+                    const Maze* maze);
+    
+    // Writes the keyframe index and completes the header, also done by the destructor
+    void finish();
+    
+    int getTurnCount() const { return turnCount; }
+    
+private:
+    std::ofstream file;
+    ReplayHeader header;
+    std::string buffer;          // records not written to the file yet
+    uint64_t bufferOffset;       // file offset of buffer[0]
+    ReplayState previous;
+    std::vector<int> changedEntities;
+    int turnCount;
+    std::vector<int64_t> removedCells;    // walls removed since the last keyframe
+    uint64_t lastWallsOffset;
+    uint64_t firstRemovalKeyframe;        // first keyframe whose removals apply to the last rows
+    uint64_t removalBytes;                // removal lists written since the last rows
+    std::vector<uint64_t> keyframeOffsets;
+    bool finished;
+    
+    void writeKeyframe(const ReplayState& state, const Maze* maze);
+    // The walls removed this turn are removedCells from firstRemoved on
+    void writeDelta(const ReplayState& state, size_t firstRemoved);
+    void putCells(size_t first);
+    void putVarint(uint64_t value);
+    void putSigned(int64_t value);
+    void flushBuffer();
+};
+
+#endif
\ No newline at end of file
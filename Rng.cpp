@@ -0,0 +1,9 @@
+#include "Rng.h"
+#include <random>
+
+using namespace std;
+
+uint64_t Rng::randomSeed() {
+    random_device device;
+    return (static_cast<uint64_t>(device()) << 32) ^ device();
+}
@@ -0,0 +1,104 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+// xoshiro256** generator owned by a single game, so games running on
+// different threads never share state and a seed always replays the
+// same game. Only integer arithmetic is used, so results are identical
+// on every platform and standard library.
+class Rng {
+public:
+    typedef uint64_t result_type;
+    
+    Rng() { seed(randomSeed()); }
+    explicit Rng(uint64_t value) { seed(value); }
+    
+    void seed(uint64_t value) {
+        // Expand the seed with splitmix64, as recommended by the xoshiro authors
+        for (int i = 0; i < 4; i++) {
+            value += 0x9E3779B97F4A7C15ULL;
+            state[i] = mix(value);
+        }
+    }
+    
+    uint64_t next() {
+        const uint64_t result = rotl(state[1] * 5, 7) * 9;
+        const uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+    
+    // Uniform integer in [0, bound), Lemire's multiply-shift without bias
+    int nextInt(int bound) {
+        uint32_t range = static_cast<uint32_t>(bound);
+        uint64_t product = (next() >> 32) * range;
+        uint32_t low = static_cast<uint32_t>(product);
+        if (low < range) {
+            uint32_t threshold = -range % range;
+            while (low < threshold) {
+                product = (next() >> 32) * range;
+                low = static_cast<uint32_t>(product);
+            }
+        }
+        return static_cast<int>(product >> 32);
+    }
+    
+    // Uniform double in [0, 1)
+    double nextDouble() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+    
+    // Fisher-Yates, independent of the std::shuffle implementation
+    template <typename T>
+    void shuffle(std::vector<T>& items) {
+        for (std::size_t i = items.size(); i > 1; i--) {
+            std::size_t j = nextInt(static_cast<int>(i));
+            std::swap(items[i - 1], items[j]);
+        }
+    }
+    
+    // UniformRandomBitGenerator interface
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~0ULL; }
+    result_type operator()() { return next(); }
+    
+    // splitmix64 finalizer, also used to derive independent seeds
+    static uint64_t mix(uint64_t value) {
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        return value ^ (value >> 31);
+    }
+    
+    static uint64_t randomSeed();
+    
+    // Full generator state, for snapshots
+    void getState(uint64_t out[4]) const {
+        for (int i = 0; i < 4; i++) {
+            out[i] = state[i];
+        }
+    }
+    
+    void setState(const uint64_t in[4]) {
+        for (int i = 0; i < 4; i++) {
+            state[i] = in[i];
+        }
+    }
+    
+private:
+    uint64_t state[4];
+    
+    static uint64_t rotl(uint64_t value, int shift) {
+        return (value << shift) | (value >> (64 - shift));
+    }
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef SNAPSHOTFORMAT_H
+#define SNAPSHOTFORMAT_H
+
+#include <cstdint>
+
+// Layout of a game snapshot (.mzs), written by Game::saveSnapshot.
+// All fields are little-endian.
+//
+//   header | payload
+//
+// The payload is a flat sequence of fixed-width fields in the order
+// Game::saveSnapshot writes them: game counters, the turn limit and flags,
+// the game RNG, how far the wall dissolve got, the key and trap tables, the
+// hero groups, the vision settings, the team map when the heroes share one,
+// and every hero (position, movement memory, RNG, blocked cells, frontier
+// and their HeroMemory tiles as raw bytes). A snapshot only loads into a game on a
+// map with the same content hash, which is also what lets the dissolve be
+// repeated instead of storing the removed walls.
+const char SNAPSHOT_MAGIC[4] = {'M', 'Z', 'S', '2'};
+const uint32_t SNAPSHOT_VERSION = 6;
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint64_t mapHash;         // Maze::getContentHash of the original map
+    uint64_t seed;
+    uint64_t payloadBytes;
+    uint64_t payloadChecksum;
+};
+
+static_assert(sizeof(SnapshotHeader) == 48, "snapshot header must stay 48 bytes");
+
+#endif
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "SnapshotStream.h"
+#include "Rng.h"
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace std;
+
+uint64_t snapshotChecksum(const char* data, size_t bytes) {
+    uint64_t hash = Rng::mix(bytes);
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = Rng::mix(hash ^ word) + i;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, bytes - i);
+    return Rng::mix(hash ^ tail);
+}
+
+void SnapshotWriter::writeFile(const string& filename, SnapshotHeader header) const {
+    header.payloadBytes = buffer.size();
+    header.payloadChecksum = snapshotChecksum(buffer.data(), buffer.size());
+    
+    string temporary = filename + ".tmp";
+    {
+        ofstream file(temporary, ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            throw runtime_error("Cannot write snapshot file: " + temporary);
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(buffer.data(), buffer.size());
+        if (!file) {
+            throw runtime_error("Cannot write snapshot file: " + temporary);
+        }
+    }
+    if (rename(temporary.c_str(), filename.c_str()) != 0) {
+        throw runtime_error("Cannot write snapshot file: " + filename);
+    }
+}
+
+SnapshotReader::SnapshotReader(const string& filename) : file(filename), position(0), end(0) {
+    if (file.getSize() < sizeof(header)) {
+        throw runtime_error("Not a snapshot file: " + filename);
+    }
+    memcpy(&header, file.getData(), sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        throw runtime_error("Not a snapshot file: " + filename);
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        throw runtime_error("Unsupported snapshot version in " + filename);
+    }
+    if (header.payloadBytes != file.getSize() - sizeof(header) ||
+        snapshotChecksum(file.getData() + sizeof(header), header.payloadBytes) != header.payloadChecksum) {
+        throw runtime_error("Corrupt snapshot file: " + filename);
+    }
+    position = sizeof(header);
+    end = file.getSize();
+}
+
+uint8_t SnapshotReader::getU8() {
+    uint8_t value;
+    getBytes(&value, sizeof(value));
+    return value;
+}
+
+uint32_t SnapshotReader::getU32() {
+    uint32_t value;
+    getBytes(&value, sizeof(value));
+    return value;
+}
+
+int32_t SnapshotReader::getI32() {
+    int32_t value;
+    getBytes(&value, sizeof(value));
+    return value;
+}
+
+uint64_t SnapshotReader::getU64() {
+    uint64_t value;
+    getBytes(&value, sizeof(value));
+    return value;
+}
+
+double SnapshotReader::getDouble() {
+    double value;
+    getBytes(&value, sizeof(value));
+    return value;
+}
+
+void SnapshotReader::getBytes(void* data, size_t bytes) {
+    if (bytes > end - position) {
+        throw runtime_error("Corrupt snapshot file");
+    }
+    memcpy(data, file.getData() + position, bytes);
+    position += bytes;
+}
\ No newline at end of file
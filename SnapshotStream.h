@@ -0,0 +1,56 @@
+#ifndef SNAPSHOTSTREAM_H
+#define SNAPSHOTSTREAM_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "SnapshotFormat.h"
+#include "MappedFile.h"
+
+// Collects the payload of a snapshot in memory and writes it in one go
+class SnapshotWriter {
+public:
+    void putU8(uint8_t value) { buffer.push_back(static_cast<char>(value)); }
+    void putU32(uint32_t value) { putBytes(&value, sizeof(value)); }
+    void putI32(int32_t value) { putBytes(&value, sizeof(value)); }
+    void putU64(uint64_t value) { putBytes(&value, sizeof(value)); }
+    void putDouble(double value) { putBytes(&value, sizeof(value)); }
+    void putBytes(const void* data, size_t bytes) { 
+        buffer.append(static_cast<const char*>(data), bytes); 
+    }
+    
+    // Fills in the payload fields of the header. The file is written under
+    // a temporary name and renamed, so a crash never leaves half a snapshot.
+    void writeFile(const std::string& filename, SnapshotHeader header) const;
+    
+private:
+    std::string buffer;
+};
+
+// Reads the payload of a mapped snapshot, every read is bounds checked
+class SnapshotReader {
+public:
+    explicit SnapshotReader(const std::string& filename);
+    
+    const SnapshotHeader& getHeader() const { return header; }
+    
+    uint8_t getU8();
+    uint32_t getU32();
+    int32_t getI32();
+    uint64_t getU64();
+    double getDouble();
+    void getBytes(void* data, size_t bytes);
+    
+    bool atEnd() const { return position == end; }
+    
+private:
+    MappedFile file;
+    SnapshotHeader header;
+    size_t position;
+    size_t end;
+};
+
+// Checksum of the payload bytes
+uint64_t snapshotChecksum(const char* data, size_t bytes);
+
+#endif
\ No newline at end of file
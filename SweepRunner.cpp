@@ -0,0 +1,232 @@
+#include "SweepRunner.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+
+using namespace std;
+
+// Quotes CSV fields that need it
+static string csvField(const string& text) {
+    if (text.find_first_of(",\"\n") == string::npos) {
+        return text;
+    }
+    string quoted = "\"";
+    for (char c : text) {
+        quoted += c;
+        if (c == '"') {
+            quoted += '"';
+        }
+    }
+    return quoted + "\"";
+}
+
+static string jsonString(const string& text) {
+    string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            quoted += ' ';
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+static const char* columnNames[] = {
+    "map", "width", "height", "heroes", "keys", "traps", "vision", "turn_limit", "hero_spacing",
+    "game", "seed", "won", "turns", "exploring_turns", "dissolving_turns", "ladder_turns", "ms", "error"
+};
+static const int COLUMN_COUNT = sizeof(columnNames) / sizeof(columnNames[0]);
+
+SweepRunner::SweepRunner(const vector<SweepMap>& sweepMaps, const SweepGrid& grid, 
+                         const GameConfig& baseConfig, int threads) 
+    : maps(sweepMaps), threadCount(threads), seed(baseConfig.seed) {
+    
+    // An empty list keeps the base value
+    auto valuesOf = [](const vector<int>& values, int base) {
+        return values.empty() ? vector<int>(1, base) : values;
+    };
+    vector<int> trapCounts = valuesOf(grid.trapCounts, baseConfig.trapCount);
+    vector<int> visionRadii = valuesOf(grid.visionRadii, baseConfig.visionRadius);
+    vector<int> turnLimits = valuesOf(grid.turnLimits, baseConfig.turnLimit);
+    vector<int> heroSpacings = valuesOf(grid.heroSpacings, baseConfig.heroSpacing);
+    
+    for (size_t map = 0; map < maps.size(); map++) {
+        for (int traps : trapCounts) {
+            for (int vision : visionRadii) {
+                for (int limit : turnLimits) {
+                    for (int spacing : heroSpacings) {
+                        Point point = {map, baseConfig};
+                        point.config.trapCount = traps;
+                        point.config.visionRadius = vision;
+                        point.config.turnLimit = limit;
+                        point.config.heroSpacing = spacing;
+                        points.push_back(point);
+                    }
+                }
+            }
+        }
+    }
+}
+
+string SweepRunner::describePoint(size_t point) const {
+    const GameConfig& config = points[point].config;
+    return maps[points[point].map].name + " traps=" + to_string(config.trapCount) + 
+           " vision=" + to_string(config.visionRadius) + " limit=" + to_string(config.turnLimit) + 
+           " spacing=" + to_string(config.heroSpacing);
+}
+
+void SweepRunner::writeRow(ostream& out, SweepFormat format, size_t point, int game, 
+                           const GameResult& result, const string& error, bool first) const {
+    const Maze& maze = maps[points[point].map].maze;
+    const GameConfig& config = points[point].config;
+    double milliseconds = 0.0;
+    for (int i = 0; i < GAME_PHASE_COUNT; i++) {
+        milliseconds += result.phaseSeconds[i] * 1000.0;
+    }
+    
+    const string& name = maps[points[point].map].name;
+    string values[COLUMN_COUNT] = {
+        format == SweepFormat::CSV ? csvField(name) : jsonString(name),
+        to_string(maze.getWidth()), to_string(maze.getHeight()), to_string(config.heroCount), 
+        to_string(config.keyCount), to_string(config.trapCount), to_string(config.visionRadius), 
+        to_string(config.turnLimit), to_string(config.heroSpacing), to_string(game), 
+        to_string(BatchRunner::gameSeed(seed, game)), result.won ? "1" : "0", to_string(result.turns), 
+        to_string(result.phaseTurns[static_cast<int>(GamePhase::EXPLORING)]), 
+        to_string(result.phaseTurns[static_cast<int>(GamePhase::WALLS_DISAPPEARING)]), 
+        to_string(result.phaseTurns[static_cast<int>(GamePhase::MOVING_TO_LADDER)]), to_string(milliseconds),
+        format == SweepFormat::CSV ? csvField(error) : (error.empty() ? "null" : jsonString(error))
+    };
+    if (format == SweepFormat::JSON) {
+        values[11] = result.won ? "true" : "false";
+    }
+    
+    if (format == SweepFormat::CSV) {
+        for (int i = 0; i < COLUMN_COUNT; i++) {
+            out << (i > 0 ? "," : "") << values[i];
+        }
+        out << '\n';
+    } else {
+        out << (first ? "  {" : ",\n  {");
+        for (int i = 0; i < COLUMN_COUNT; i++) {
+            out << (i > 0 ? ", \"" : "\"") << columnNames[i] << "\": " << values[i];
+        }
+        out << "}";
+    }
+}
+
+vector<SweepPointStats> SweepRunner::run(int gamesPerPoint, ostream& out, SweepFormat format) {
+    if (gamesPerPoint < 1 || points.size() > static_cast<size_t>(INT_MAX / gamesPerPoint)) {
+        throw runtime_error("Sweep needs between 1 and " + to_string(INT_MAX) + " games");
+    }
+    int total = static_cast<int>(points.size()) * gamesPerPoint;
+    vector<GameResult> results(total);
+    vector<string> errors(total);
+    vector<char> finished(total, 0);
+    int written = 0;
+    
+    if (format == SweepFormat::CSV) {
+        for (int i = 0; i < COLUMN_COUNT; i++) {
+            out << (i > 0 ? "," : "") << columnNames[i];
+        }
+        out << '\n';
+    } else {
+        out << "[\n";
+    }
+    
+    auto start = chrono::steady_clock::now();
+    
+    // Exceptions can't cross threads, keep the first one and rethrow it here
+    exception_ptr failure;
+    mutex outputMutex;
+    
+    ThreadPool pool(threadCount);
+    threadCount = pool.getThreadCount();
+    pool.parallelFor(total, [&](int index, int worker) {
+        size_t point = index / gamesPerPoint;
+        int game = index % gamesPerPoint;
+        try {
+            GameConfig gameConfig = points[point].config;
+            gameConfig.seed = BatchRunner::gameSeed(seed, game);
+            Game played(maps[points[point].map].maze, new NullRenderer(), gameConfig);
+            results[index] = played.runToCompletion();
+        } catch (const runtime_error& e) {
+            // A game that can't be set up at this point, e.g. no room for
+            // the hero spacing, is a failed row rather than the end of the sweep
+            errors[index] = e.what();
+        } catch (...) {
+            lock_guard<mutex> lock(outputMutex);
+            if (!failure) {
+                failure = current_exception();
+            }
+        }
+        
+        // Rows leave in order: whoever finishes the oldest pending game
+        // writes it and every finished game after it
+        lock_guard<mutex> lock(outputMutex);
+        finished[index] = 1;
+        if (failure || !finished[written]) {
+            return;
+        }
+        while (written < total && finished[written]) {
+            writeRow(out, format, written / gamesPerPoint, written % gamesPerPoint, results[written], 
+                     errors[written], written == 0);
+            written++;
+        }
+        out.flush();
+    });
+    
+    // The rows written so far stay a valid document
+    if (format == SweepFormat::JSON) {
+        out << (written > 0 ? "\n]\n" : "]\n");
+    }
+    out.flush();
+    if (failure) {
+        rethrow_exception(failure);
+    }
+    
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    vector<SweepPointStats> stats(points.size());
+    for (size_t point = 0; point < points.size(); point++) {
+        BatchStats& pointStats = stats[point].games;
+        pointStats.games = 0;
+        pointStats.wins = 0;
+        pointStats.losses = 0;
+        pointStats.wallSeconds = seconds;
+        for (int i = 0; i < GAME_PHASE_COUNT; i++) {
+            pointStats.phaseTurns[i] = 0;
+            pointStats.phaseSeconds[i] = 0.0;
+        }
+        stats[point].failedGames = 0;
+        for (int game = 0; game < gamesPerPoint; game++) {
+            size_t index = point * gamesPerPoint + game;
+            if (!errors[index].empty()) {
+                if (stats[point].failedGames++ == 0) {
+                    stats[point].error = errors[index];
+                }
+                continue;
+            }
+            const GameResult& result = results[index];
+            pointStats.games++;
+            if (result.won) {
+                pointStats.wins++;
+            } else {
+                pointStats.losses++;
+            }
+            pointStats.turnCounts.push_back(result.turns);
+            for (int i = 0; i < GAME_PHASE_COUNT; i++) {
+                pointStats.phaseTurns[i] += result.phaseTurns[i];
+                pointStats.phaseSeconds[i] += result.phaseSeconds[i];
+            }
+        }
+        sort(pointStats.turnCounts.begin(), pointStats.turnCounts.end());
+    }
+    return stats;
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef SWEEPRUNNER_H
+#define SWEEPRUNNER_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "BatchRunner.h"
+#include "Game.h"
+#include "Maze.h"
+
+// A map of the sweep and the name its rows carry
+struct SweepMap {
+    std::string name;
+    Maze maze;
+};
+
+// Values of the swept parameters, every combination on every map is one
+// sweep point. Everything else comes from the base GameConfig.
+struct SweepGrid {
+    std::vector<int> trapCounts;
+    std::vector<int> visionRadii;
+    std::vector<int> turnLimits;
+    std::vector<int> heroSpacings;
+};
+
+enum class SweepFormat {
+    CSV,     // header line, then one line per game
+    JSON     // an array with one object per game, one per line
+};
+
+// Outcome of one sweep point. Games that could not be set up there (no
+// room for the hero spacing, say) count as failed, not as played.
+struct SweepPointStats {
+    BatchStats games;
+    int failedGames;
+    std::string error;     // message of the first failed game
+};
+
+// Plays headless games for every point of a parameter grid and streams
+// one row per game. All games of the sweep share one thread pool, so
+// small points don't leave threads idle. Game i of every point uses the
+// seed BatchRunner would give it, so the points are compared on the same
+// seeds, and rows are written in point and game order whatever the
+// thread count.
+class SweepRunner {
+public:
+    SweepRunner(const std::vector<SweepMap>& sweepMaps, const SweepGrid& sweepGrid, 
+                const GameConfig& baseConfig, int threads);
+    
+    size_t getPointCount() const { return points.size(); }
+    int getThreadCount() const { return threadCount; }
+    // Short description of a point, like "map1.txt traps=2 vision=1 limit=1000 spacing=7"
+    std::string describePoint(size_t point) const;
+    
+    // Plays gamesPerPoint games per point, writing each row as soon as the
+    // rows before it are written; a failed game gets a row with its error.
+    // Returns the statistics of every point, their wallSeconds is the time
+    // of the whole sweep. Other exceptions end the sweep after the output
+    // is closed.
+    std::vector<SweepPointStats> run(int gamesPerPoint, std::ostream& out, SweepFormat format);
+    
+private:
+    struct Point {
+        size_t map;
+        GameConfig config;
+    };
+    
+    const std::vector<SweepMap>& maps;
+    std::vector<Point> points;
+    int threadCount;
+    uint64_t seed;
+    
+    void writeRow(std::ostream& out, SweepFormat format, size_t point, int game, 
+                  const GameResult& result, const std::string& error, bool first) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "TeamMap.h"
+#include "SnapshotStream.h"
+#include <stdexcept>
+
+using namespace std;
+
+TeamMap::TeamMap(int mapWidth, int mapHeight, size_t capacity)
+    : width(mapWidth), height(mapHeight), 
+      codeRowWords((mapWidth + 31) / 32), visitedRowWords((mapWidth + 63) / 64),
+      journalCapacity(capacity), journalSize(0) {
+    
+    size_t codeWords = codeRowWords * height;
+    size_t visitedWords = visitedRowWords * height;
+    codes.reset(new atomic<uint64_t>[codeWords]);
+    visited.reset(new atomic<uint64_t>[visitedWords]);
+    for (size_t i = 0; i < codeWords; i++) {
+        codes[i].store(0, memory_order_relaxed);
+    }
+    for (size_t i = 0; i < visitedWords; i++) {
+        visited[i].store(0, memory_order_relaxed);
+    }
+    journal.reset(new uint64_t[journalCapacity]);
+}
+
+void TeamMap::markVisited(int x, int y) {
+    if (x >= 0 && x < width && y >= 0 && y < height) {
+        visited[static_cast<size_t>(y) * visitedRowWords + (x >> 6)].fetch_or(1ULL << (x & 63), memory_order_relaxed);
+    }
+}
+
+uint64_t TeamMap::publishRow(int y, int x0, int x1, uint64_t wallBits, uint64_t columnMask) {
+    if (y < 0 || y >= height || x0 < 0 || x1 >= width || x0 > x1 || x1 - x0 >= 64) {
+        return 0;
+    }
+    
+    int count = x1 - x0 + 1;
+    if (count < 64) {
+        columnMask &= (1ULL << count) - 1;
+    }
+    
+    uint64_t changed = 0;
+    int x = x0;
+    while (x <= x1) {
+        int last = min(x1, x | 31);
+        int offset = x - x0;
+        int cells = last - x + 1;
+        uint32_t cellMask = static_cast<uint32_t>(columnMask >> offset) & (cells == 32 ? ~0U : (1U << cells) - 1);
+        if (cellMask) {
+            atomic<uint64_t>& word = codes[static_cast<size_t>(y) * codeRowWords + (x >> 5)];
+            int shift = (x & 31) * 2;
+            uint32_t walls = static_cast<uint32_t>(wallBits >> offset);
+            uint64_t newCodes = (HeroMemory::spreadBits(~walls & cellMask) | 
+                                 (HeroMemory::spreadBits(walls & cellMask) << 1)) << shift;
+            uint64_t mask = (HeroMemory::spreadBits(cellMask) * 3) << shift;
+            
+            // Retry until no other hero changed the word in between. Only
+            // the cells this call actually changed go to the journal, so
+            // a cell seen by several heroes is recorded once.
+            uint64_t current = word.load(memory_order_relaxed);
+            uint64_t updated;
+            do {
+                updated = (current & ~mask) | newCodes;
+            } while (updated != current && 
+                     !word.compare_exchange_weak(current, updated, memory_order_relaxed));
+            
+            uint64_t diff = current ^ updated;
+            uint32_t changedCells = HeroMemory::compactBits((diff | (diff >> 1)) >> shift);
+            if (changedCells) {
+                size_t slot = journalSize.fetch_add(__builtin_popcount(changedCells), memory_order_relaxed);
+                for (uint32_t bits = changedCells; bits; bits &= bits - 1) {
+                    int cellX = x + __builtin_ctz(bits);
+                    if (slot < journalCapacity) {
+                        uint64_t cell = static_cast<uint64_t>(y) * width + cellX;
+                        journal[slot] = cell * 4 + ((updated >> ((cellX & 31) * 2)) & 3);
+                    }
+                    slot++;
+                }
+                changed |= static_cast<uint64_t>(changedCells) << offset;
+            }
+        }
+        x = last + 1;
+    }
+    return changed;
+}
+
+size_t TeamMap::getKnownCells() const {
+    size_t known = 0;
+    for (size_t i = 0; i < codeRowWords * height; i++) {
+        uint64_t word = codes[i].load(memory_order_relaxed);
+        known += __builtin_popcountll((word | (word >> 1)) & 0x5555555555555555ULL);
+    }
+    return known;
+}
+
+void TeamMap::save(SnapshotWriter& out) const {
+    for (size_t i = 0; i < codeRowWords * height; i++) {
+        out.putU64(codes[i].load(memory_order_relaxed));
+    }
+    for (size_t i = 0; i < visitedRowWords * height; i++) {
+        out.putU64(visited[i].load(memory_order_relaxed));
+    }
+}
+
+void TeamMap::load(SnapshotReader& in) {
+    for (size_t i = 0; i < codeRowWords * height; i++) {
+        codes[i].store(in.getU64(), memory_order_relaxed);
+    }
+    for (size_t i = 0; i < visitedRowWords * height; i++) {
+        visited[i].store(in.getU64(), memory_order_relaxed);
+    }
+    clearJournal();
+}
\ No newline at end of file
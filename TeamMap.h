@@ -0,0 +1,81 @@
+#ifndef TEAMMAP_H
+#define TEAMMAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "HeroMemory.h"
+
+class SnapshotWriter;
+class SnapshotReader;
+
+// What the whole team knows about the map, shared by every hero of a game.
+// Cells use the HeroMemory codes, 32 per 64-bit word, plus one visited bit
+// per cell. Heroes publish with a compare-and-swap per word, so several
+// decision threads can merge their views at the same time without a lock.
+//
+// Every cell whose code a publish changes is also appended to a journal,
+// which the heroes read back into their own memory (Hero::syncTeamMap).
+// Game keeps publishing and reading in separate phases of a turn: what a
+// hero reads is then the same whatever order the others published in.
+class TeamMap {
+public:
+    // journalCapacity bounds the cells that change between two clearJournal
+    TeamMap(int mapWidth, int mapHeight, size_t journalCapacity);
+
+    TeamMap(const TeamMap&) = delete;
+    TeamMap& operator=(const TeamMap&) = delete;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // Out of bounds cells read as WALL, like HeroMemory
+    int getCode(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) {
+            return HeroMemory::WALL;
+        }
+        uint64_t word = codes[static_cast<size_t>(y) * codeRowWords + (x >> 5)].load(std::memory_order_relaxed);
+        return (word >> ((x & 31) * 2)) & 3;
+    }
+
+    bool isVisited(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) {
+            return false;
+        }
+        uint64_t word = visited[static_cast<size_t>(y) * visitedRowWords + (x >> 6)].load(std::memory_order_relaxed);
+        return (word >> (x & 63)) & 1;
+    }
+
+    void markVisited(int x, int y);
+
+    // Same arguments as HeroMemory::mergeRow. Thread-safe; returns the
+    // columns this call changed, which are also added to the journal.
+    uint64_t publishRow(int y, int x0, int x1, uint64_t wallBits, uint64_t columnMask);
+
+    // Journal entries are (y * width + x) * 4 + code. Only read them
+    // while nobody publishes, and clear between turns.
+    size_t getJournalSize() const { return std::min(journalSize.load(std::memory_order_acquire), journalCapacity); }
+    uint64_t getJournalEntry(size_t index) const { return journal[index]; }
+    void clearJournal() { journalSize.store(0, std::memory_order_relaxed); }
+
+    size_t getKnownCells() const;
+
+    // Codes and visited bits, the journal is not saved
+    void save(SnapshotWriter& out) const;
+    void load(SnapshotReader& in);
+
+private:
+    int width, height;
+    size_t codeRowWords;      // 32 cells per word
+    size_t visitedRowWords;   // 64 cells per word
+    std::unique_ptr<std::atomic<uint64_t>[]> codes;
+    std::unique_ptr<std::atomic<uint64_t>[]> visited;
+
+    size_t journalCapacity;
+    std::atomic<size_t> journalSize;
+    std::unique_ptr<uint64_t[]> journal;
+};
+
+#endif
\ No newline at end of file
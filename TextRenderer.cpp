@@ -0,0 +1,46 @@
+#include "TextRenderer.h"
+#include "Maze.h"
+
+using namespace std;
+
+TextRenderer::TextRenderer(ostream& output) : out(output) {
+}
+
+void TextRenderer::drawFrame(const Maze* maze, const RenderFrame& frame) {
+    out << "Turn " << frame.turn;
+    if (!frame.status.empty()) {
+        out << " - " << frame.status;
+    }
+    out << '\n';
+    
+    for (int y = 0; y < maze->getHeight(); y++) {
+        rowBuffer.assign(maze->getWidth(), ' ');
+        for (int x = 0; x < maze->getWidth(); x++) {
+            rowBuffer[x] = maze->getCell(x, y);
+        }
+        if (y == maze->getLadderY()) {
+            rowBuffer[maze->getLadderX()] = 'L';
+        }
+        
+        // Later sprites overwrite earlier ones, like on screen
+        for (const auto& sprite : frame.sprites) {
+            if (sprite.y == y && sprite.x >= 0 && sprite.x < maze->getWidth()) {
+                rowBuffer[sprite.x] = sprite.symbol;
+            }
+        }
+        out << rowBuffer << '\n';
+    }
+    out << '\n';
+}
+
+void TextRenderer::logMessage(const string& message) {
+    out << message << '\n';
+}
+
+void TextRenderer::showResult(const Maze* maze, bool won) {
+    if (won) {
+        out << "Congratulations! The heroes saved the kingdom!" << endl;
+    } else {
+        out << "Game Over! The kingdom has fallen..." << endl;
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef TEXTRENDERER_H
+#define TEXTRENDERER_H
+
+#include <iostream>
+#include <string>
+#include "Renderer.h"
+
+// Dumps every frame as plain text, useful for logs and CI
+class TextRenderer : public Renderer {
+public:
+    TextRenderer(std::ostream& output);
+    
+    void drawFrame(const Maze* maze, const RenderFrame& frame) override;
+    void logMessage(const std::string& message) override;
+    void showResult(const Maze* maze, bool won) override;
+    
+private:
+    std::ostream& out;
+    std::string rowBuffer;
+};
+
+#endif
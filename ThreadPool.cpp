@@ -0,0 +1,92 @@
+#include "ThreadPool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(int threads) 
+    : threadCount(threads), job(nullptr), jobSize(0), nextIndex(0), busyWorkers(0),
+      generation(0), stopping(false) {
+    
+    if (threadCount <= 0) {
+        threadCount = thread::hardware_concurrency();
+        if (threadCount <= 0) {
+            threadCount = 1;
+        }
+    }
+    
+    // The calling thread works too, as worker 0
+    for (int i = 1; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(poolMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const function<void(int, int)>& task) {
+    if (count <= 0) {
+        return;
+    }
+    
+    if (workers.empty() || count == 1) {
+        for (int i = 0; i < count; i++) {
+            task(i, 0);
+        }
+        return;
+    }
+    
+    {
+        lock_guard<mutex> lock(poolMutex);
+        job = &task;
+        jobSize = count;
+        nextIndex.store(0);
+        busyWorkers = workers.size();
+        generation++;
+    }
+    wakeUp.notify_all();
+    
+    runJob(0);
+    
+    unique_lock<mutex> lock(poolMutex);
+    finished.wait(lock, [this] { return busyWorkers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::workerLoop(int worker) {
+    unsigned seenGeneration = 0;
+    while (true) {
+        {
+            unique_lock<mutex> lock(poolMutex);
+            wakeUp.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+        
+        runJob(worker);
+        
+        {
+            lock_guard<mutex> lock(poolMutex);
+            busyWorkers--;
+        }
+        finished.notify_one();
+    }
+}
+
+void ThreadPool::runJob(int worker) {
+    while (true) {
+        int index = nextIndex.fetch_add(1);
+        if (index >= jobSize) {
+            return;
+        }
+        (*job)(index, worker);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that run index ranges in parallel.
+// parallelFor blocks until every index has been processed.
+class ThreadPool {
+public:
+    // 0 threads means one per hardware core
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    int getThreadCount() const { return threadCount; }
+    
+    // Calls task(index, worker) for every index in [0, count).
+    // worker is in [0, getThreadCount()) and identifies the calling thread.
+    void parallelFor(int count, const std::function<void(int, int)>& task);
+    
+private:
+    int threadCount;
+    std::vector<std::thread> workers;
+    
+    std::mutex poolMutex;
+    std::condition_variable wakeUp;
+    std::condition_variable finished;
+    
+    // Current job, guarded by poolMutex except for the atomic counter
+    const std::function<void(int, int)>* job;
+    int jobSize;
+    std::atomic<int> nextIndex;
+    int busyWorkers;
+    unsigned generation;
+    bool stopping;
+    
+    void workerLoop(int worker);
+    void runJob(int worker);
+};
+
+#endif
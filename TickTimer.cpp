@@ -0,0 +1,43 @@
+#include "TickTimer.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+TickTimer::TickTimer(chrono::microseconds interval) : fd(-1) {
+    fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        throw runtime_error(string("Cannot create tick timer: ") + strerror(errno));
+    }
+    
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = interval.count() / 1000000;
+    spec.it_interval.tv_nsec = (interval.count() % 1000000) * 1000;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(fd, 0, &spec, nullptr) != 0) {
+        close(fd);
+        throw runtime_error(string("Cannot start tick timer: ") + strerror(errno));
+    }
+}
+
+TickTimer::~TickTimer() {
+    close(fd);
+}
+
+uint64_t TickTimer::wait(int inputFd) {
+    struct pollfd fds[2] = {{fd, POLLIN, 0}, {inputFd, POLLIN, 0}};
+    if (poll(fds, inputFd >= 0 ? 2 : 1, -1) < 0 && errno != EINTR) {
+        throw runtime_error(string("Cannot wait for input: ") + strerror(errno));
+    }
+    
+    // Expirations since the last read, the timer keeps running meanwhile
+    uint64_t ticks = 0;
+    if (read(fd, &ticks, sizeof(ticks)) != sizeof(ticks)) {
+        return 0;
+    }
+    return ticks;
+}
\ No newline at end of file
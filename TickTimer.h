@@ -0,0 +1,28 @@
+#ifndef TICKTIMER_H
+#define TICKTIMER_H
+
+#include <chrono>
+#include <cstdint>
+
+// Periodic ticks from a timerfd, for the interactive loops. The ticks
+// follow the clock rather than the end of the work done between them, so
+// they don't drift, and waiting for the next one also wakes up as soon as
+// a key arrives instead of polling.
+class TickTimer {
+public:
+    explicit TickTimer(std::chrono::microseconds interval);
+    ~TickTimer();
+    
+    TickTimer(const TickTimer&) = delete;
+    TickTimer& operator=(const TickTimer&) = delete;
+    
+    // Blocks until the next tick or until inputFd (-1 for none) is readable.
+    // Returns the ticks since the last call, 0 when input or a signal
+    // (e.g. a terminal resize) woke it first.
+    uint64_t wait(int inputFd);
+    
+private:
+    int fd;
+};
+
+#endif
\ No newline at end of file
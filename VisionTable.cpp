@@ -0,0 +1,92 @@
+#include "VisionTable.h"
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+using namespace std;
+
+const VisionTable& VisionTable::get(int radius) {
+    if (radius < 1 || radius > MAX_RADIUS) {
+        throw runtime_error("Vision radius must be between 1 and " + to_string(MAX_RADIUS));
+    }
+    
+    // Tables are never freed, so references stay valid for the whole program
+    static mutex tablesMutex;
+    static map<int, unique_ptr<VisionTable>> tables;
+    
+    lock_guard<mutex> lock(tablesMutex);
+    unique_ptr<VisionTable>& table = tables[radius];
+    if (!table) {
+        table.reset(new VisionTable(radius));
+    }
+    return *table;
+}
+
+VisionTable::VisionTable(int visionRadius) 
+    : radius(visionRadius), side(2 * visionRadius + 1), cellsInRange(0) {
+    
+    rangeMask.assign(side * side, 0);
+    rowMin.assign(side, 0);
+    rowMax.assign(side, -1);
+    int limit = radius * (radius + 1);
+    for (int dy = -radius; dy <= radius; dy++) {
+        for (int dx = -radius; dx <= radius; dx++) {
+            if (dx * dx + dy * dy <= limit) {
+                rangeMask[index(dx, dy)] = 1;
+                cellsInRange++;
+                rowMin[dy + radius] = min(rowMin[dy + radius], dx);
+                rowMax[dy + radius] = max(rowMax[dy + radius], dx);
+            }
+        }
+    }
+    
+    // Rings of growing Chebyshev distance, parents are always one ring further in
+    for (int ring = 1; ring <= radius; ring++) {
+        for (int dy = -ring; dy <= ring; dy++) {
+            for (int dx = -ring; dx <= ring; dx++) {
+                if (max(abs(dx), abs(dy)) == ring) {
+                    sightOrder.push_back(index(dx, dy));
+                }
+            }
+        }
+    }
+    
+    parentStart.assign(side * side + 1, 0);
+    vector<vector<int>> cellParents(side * side);
+    for (int cell : sightOrder) {
+        int dx = cell % side - radius;
+        int dy = cell / side - radius;
+        int ring = max(abs(dx), abs(dy));
+        
+        // The point on the line one ring closer, rounded to a cell. When
+        // it lies exactly between two cells, both are parents.
+        vector<int> xs, ys;
+        for (int axis = 0; axis < 2; axis++) {
+            int value = axis == 0 ? dx : dy;
+            vector<int>& out = axis == 0 ? xs : ys;
+            int numerator = abs(value) * (ring - 1);
+            int whole = numerator / ring;
+            int twiceRemainder = 2 * (numerator % ring);
+            int sign = value < 0 ? -1 : 1;
+            if (twiceRemainder == ring) {
+                out.push_back(sign * whole);
+                out.push_back(sign * (whole + 1));
+            } else {
+                out.push_back(sign * (whole + (twiceRemainder > ring ? 1 : 0)));
+            }
+        }
+        for (int py : ys) {
+            for (int px : xs) {
+                cellParents[cell].push_back(index(px, py));
+            }
+        }
+    }
+    for (int cell = 0; cell < side * side; cell++) {
+        parentStart[cell] = parents.size();
+        parents.insert(parents.end(), cellParents[cell].begin(), cellParents[cell].end());
+    }
+    parentStart[side * side] = parents.size();
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef VISIONTABLE_H
+#define VISIONTABLE_H
+
+#include <vector>
+
+// Field of view for one vision radius, built once and shared by every
+// hero with that radius. Cells are offsets (dx, dy) from the hero inside
+// the (2r + 1) x (2r + 1) window, numbered row-major. A cell is in range
+// when dx^2 + dy^2 <= r * (r + 1), which is the full 3x3 window at r = 1.
+//
+// For line of sight every cell has one to four parents, the cells next to
+// it on the way back to the hero along the straight line. A cell is seen
+// when one of its parents is seen and is not a wall, so walls cast shadows
+// that can be computed in one pass over the cells in sight order.
+class VisionTable {
+public:
+    static const int MAX_RADIUS = 127;
+    
+    // Shared table for this radius, thread-safe
+    static const VisionTable& get(int radius);
+    
+    int getRadius() const { return radius; }
+    int getSide() const { return side; }
+    int getCenter() const { return radius * side + radius; }
+    int getCellsInRange() const { return cellsInRange; }
+    
+    int index(int dx, int dy) const { return (dy + radius) * side + dx + radius; }
+    bool inRange(int index) const { return rangeMask[index] != 0; }
+    
+    // Row dy is in range for dx in [getRowMin(dy), getRowMax(dy)]
+    int getRowMin(int dy) const { return rowMin[dy + radius]; }
+    int getRowMax(int dy) const { return rowMax[dy + radius]; }
+    
+    // Every cell but the hero's own, nearer cells first
+    const std::vector<int>& getSightOrder() const { return sightOrder; }
+    const int* parentsBegin(int index) const { return parents.data() + parentStart[index]; }
+    const int* parentsEnd(int index) const { return parents.data() + parentStart[index + 1]; }
+    
+private:
+    int radius;
+    int side;
+    int cellsInRange;
+    std::vector<unsigned char> rangeMask;
+    std::vector<int> rowMin;
+    std::vector<int> rowMax;
+    std::vector<int> sightOrder;
+    std::vector<int> parentStart;
+    std::vector<int> parents;
+    
+    explicit VisionTable(int visionRadius);
+};
+
+#endif
\ No newline at end of file
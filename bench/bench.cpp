@@ -0,0 +1,358 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include "Game.h"
+#include "Hero.h"
+#include "Maze.h"
+#include "MazeGenerator.h"
+#include "DistanceOracle.h"
+#include "Profiler.h"
+
+using namespace std;
+
+// Allocations are counted by the operator new in Profiler.cpp, so the
+// allocation columns read 0 in a -DMAZE_NO_PROFILE build
+static long long allocationCount() {
+    return static_cast<long long>(Profiler::threadAllocations());
+}
+
+// Keeps results alive so the optimizer can't drop the measured work
+static volatile long long sink = 0;
+
+struct BenchResult {
+    string name;
+    string map;
+    long long cells;
+    long long operations;
+    double nsPerOp;
+    double allocsPerOp;
+    double turnsPerSecond;   // only for full games, 0 otherwise
+};
+
+struct BenchMap {
+    string name;
+    string path;      // empty for generated maps
+    Maze maze;
+};
+
+static double minSeconds = 0.2;
+static int heroThreads = 1;
+
+// Time and allocations of the untimed() work in the current measure()
+static double untimedSeconds = 0.0;
+static long long untimedAllocations = 0;
+
+// Allocations the body made on other threads, which allocationCount() misses
+static long long otherThreadAllocations = 0;
+
+// Runs setup work between operations without counting it
+static void untimed(const function<void()>& work) {
+    long long allocationsBefore = allocationCount();
+    auto start = chrono::steady_clock::now();
+    work();
+    untimedSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    untimedAllocations += allocationCount() - allocationsBefore;
+}
+
+// Runs body(iteration) in growing batches until minSeconds have passed
+static BenchResult measure(const string& name, const BenchMap& map, const function<void(long long)>& body) {
+    long long batch = 1;
+    long long operations = 0;
+    double seconds = 0.0;
+    untimedSeconds = 0.0;
+    untimedAllocations = 0;
+    otherThreadAllocations = 0;
+    long long allocationsBefore = allocationCount();
+    
+    while (seconds - untimedSeconds < minSeconds) {
+        auto start = chrono::steady_clock::now();
+        for (long long i = 0; i < batch; i++) {
+            body(operations + i);
+        }
+        seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        operations += batch;
+        if (batch < (1LL << 30)) {
+            batch *= 2;
+        }
+    }
+    
+    BenchResult result;
+    result.name = name;
+    result.map = map.name;
+    result.cells = static_cast<long long>(map.maze.getWidth()) * map.maze.getHeight();
+    result.operations = operations;
+    result.nsPerOp = (seconds - untimedSeconds) * 1e9 / operations;
+    long long allocations = allocationCount() - allocationsBefore - untimedAllocations + otherThreadAllocations;
+    result.allocsPerOp = static_cast<double>(allocations) / operations;
+    result.turnsPerSecond = 0.0;
+    return result;
+}
+
+static vector<pair<int, int>> openCells(const Maze& maze) {
+    vector<pair<int, int>> cells;
+    for (int y = 1; y < maze.getHeight() - 1; y++) {
+        for (int x = 1; x < maze.getWidth() - 1; x++) {
+            if (!maze.isWall(x, y)) {
+                cells.push_back({x, y});
+            }
+        }
+    }
+    return cells;
+}
+
+static void benchMap(const BenchMap& map, vector<BenchResult>& results) {
+    const Maze& maze = map.maze;
+    vector<pair<int, int>> cells = openCells(maze);
+    Rng rng(1);
+    
+    // Random probe positions, fixed up front so the lookup itself is measured
+    const int probeCount = 4096;
+    vector<pair<int, int>> probes(probeCount);
+    for (auto& probe : probes) {
+        probe = {rng.nextInt(maze.getWidth()), rng.nextInt(maze.getHeight())};
+    }
+    
+    results.push_back(measure("Maze::getCell", map, [&](long long i) {
+        const auto& probe = probes[i & (probeCount - 1)];
+        sink += maze.getCell(probe.first, probe.second);
+    }));
+    
+    results.push_back(measure("Maze::isWall", map, [&](long long i) {
+        const auto& probe = probes[i & (probeCount - 1)];
+        sink += maze.isWall(probe.first, probe.second);
+    }));
+    
+    if (!map.path.empty()) {
+        results.push_back(measure("Maze::Maze(file)", map, [&](long long) {
+            Maze loaded(map.path);
+            sink += loaded.getWidth();
+        }));
+    }
+    
+    results.push_back(measure("Maze copy", map, [&](long long) {
+        Maze copy(maze);
+        sink += copy.getHeight();
+    }));
+    
+    // Hero queries from random open cells
+    Hero probeHero(cells[0].first, cells[0].second, 'G', "Bench", maze.getWidth(), maze.getHeight(), 1);
+    results.push_back(measure("Hero::getValidMoves", map, [&](long long i) {
+        const auto& cell = cells[(i * 7919) % cells.size()];
+        probeHero.setPosition(cell.first, cell.second);
+        sink += probeHero.getValidMoves(&maze).size();
+    }));
+    
+    results.push_back(measure("Hero::updateVision", map, [&](long long i) {
+        const auto& cell = cells[(i * 7919) % cells.size()];
+        probeHero.setPosition(cell.first, cell.second);
+        probeHero.updateVision(&maze);
+    }));
+    
+    Hero farSighted(cells[0].first, cells[0].second, 'G', "Bench", maze.getWidth(), maze.getHeight(), 1);
+    farSighted.setVision(8, true);
+    results.push_back(measure("Hero::updateVision (r=8 LOS)", map, [&](long long i) {
+        const auto& cell = cells[(i * 7919) % cells.size()];
+        farSighted.setPosition(cell.first, cell.second);
+        farSighted.updateVision(&maze);
+    }));
+    
+    // A hero exploring on its own: vision, decision and move every turn
+    Hero walker(cells[0].first, cells[0].second, 'S', "Bench", maze.getWidth(), maze.getHeight(), 2);
+    results.push_back(measure("Hero::decideNextMove", map, [&](long long) {
+        walker.updateVision(&maze);
+        pair<int, int> next = walker.decideNextMove(&maze);
+        if (!maze.isWall(next.first, next.second)) {
+            walker.setPosition(next.first, next.second);
+        }
+        sink += next.first;
+    }));
+    
+    // Shortest paths on the real map between random open cells, plain and
+    // with landmark bounds from the distance oracle
+    results.push_back(measure("DistanceOracle (8 landmarks)", map, [&](long long) {
+        DistanceOracle oracle(maze, 8);
+        sink += oracle.getLandmarkCount();
+    }));
+    
+    shared_ptr<const DistanceOracle> oracle = DistanceOracle::get(maze, 8);
+    Pathfinder pathfinder;
+    auto isOpen = [&maze](int x, int y) { return !maze.isWallUnchecked(x, y); };
+    results.push_back(measure("Pathfinder A* (Manhattan)", map, [&](long long i) {
+        const auto& from = cells[(i * 7919) % cells.size()];
+        const auto& to = cells[(i * 104729 + 1) % cells.size()];
+        pathfinder.findNextStep(0, 0, maze.getWidth() - 1, maze.getHeight() - 1, 
+                                from.first, from.second, to.first, to.second, isOpen);
+        sink += pathfinder.getLastPathLength();
+    }));
+    
+    results.push_back(measure("Pathfinder A* (landmarks)", map, [&](long long i) {
+        const auto& from = cells[(i * 7919) % cells.size()];
+        const auto& to = cells[(i * 104729 + 1) % cells.size()];
+        pathfinder.findNextStepWithHeuristic(0, 0, maze.getWidth() - 1, maze.getHeight() - 1, 
+                                             from.first, from.second, to.first, to.second, isOpen,
+            [&oracle, &to](int x, int y) { return oracle->lowerBound(x, y, to.first, to.second); });
+        sink += pathfinder.getLastPathLength();
+    }));
+    
+    // Game construction is dominated by placeObjectsRandomly
+    results.push_back(measure("Game::placeObjectsRandomly", map, [&](long long i) {
+        Game game(maze, new NullRenderer(), GameConfig(i));
+        sink += game.getTurns();
+    }));
+    
+    // Full headless games
+    long long totalTurns = 0;
+    BenchResult games = measure("Game::runToCompletion", map, [&](long long i) {
+        Game game(maze, new NullRenderer(), GameConfig(i));
+        totalTurns += game.runToCompletion().turns;
+    });
+    games.turnsPerSecond = totalTurns / (games.nsPerOp * games.operations / 1e9);
+    results.push_back(games);
+    
+    // Crowded games, the case the parallel decision phase and the team map are for
+    if (cells.size() >= 10000) {
+        for (int shared = 0; shared < 2; shared++) {
+            GameConfig crowd(1);
+            crowd.heroCount = 16;
+            crowd.trapCount = 16;
+            crowd.keyCount = 8;
+            crowd.decisionThreads = heroThreads;
+            crowd.sharedMap = shared != 0;
+            Game* game = new Game(maze, new NullRenderer(), crowd);
+            BenchResult steps = measure(shared ? "Game::step (16, shared map)" : "Game::step (16 heroes)", map, 
+                                        [&](long long i) {
+                uint64_t workerAllocations = game->getWorkerAllocations();
+                bool running = game->step();
+                otherThreadAllocations += game->getWorkerAllocations() - workerAllocations;
+                if (!running) {
+                    untimed([&]() {
+                        delete game;
+                        crowd.seed = i + 2;
+                        game = new Game(maze, new NullRenderer(), crowd);
+                    });
+                }
+            });
+            delete game;
+            steps.turnsPerSecond = 1e9 / steps.nsPerOp;
+            results.push_back(steps);
+        }
+    }
+}
+
+static string jsonString(const string& text) {
+    string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            quoted += ' ';
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+static void writeJson(const string& filename, const string& label, const vector<BenchResult>& results) {
+    ofstream out(filename);
+    if (!out.is_open()) {
+        throw runtime_error("Cannot write " + filename);
+    }
+    out << "{\n  \"label\": " << jsonString(label) << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": " << jsonString(r.name) << ", \"map\": " << jsonString(r.map) << ", \"cells\": " << r.cells
+            << ", \"ops\": " << r.operations << ", \"ns_per_op\": " << r.nsPerOp 
+            << ", \"allocs_per_op\": " << r.allocsPerOp << ", \"turns_per_sec\": " << r.turnsPerSecond << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [--max-size N] [--min-time S] [--hero-threads T] [--json out.json] [--label L] [map files...]" << endl;
+    cerr << "  Benchmarks the given maps (default map1.txt map2.dat) plus generated" << endl;
+    cerr << "  backtracker mazes of 65, 257, 1025... cells per side up to --max-size (default 1025)." << endl;
+}
+
+int main(int argc, char* argv[]) {
+    int maxSize = 1025;
+    string jsonFile;
+    string label;
+    vector<string> mapFiles;
+    
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--max-size" && i + 1 < argc) {
+                maxSize = stoi(argv[++i]);
+            } else if (arg == "--min-time" && i + 1 < argc) {
+                minSeconds = stod(argv[++i]);
+            } else if (arg == "--hero-threads" && i + 1 < argc) {
+                heroThreads = stoi(argv[++i]);
+            } else if (arg == "--json" && i + 1 < argc) {
+                jsonFile = argv[++i];
+            } else if (arg == "--label" && i + 1 < argc) {
+                label = argv[++i];
+            } else if (arg[0] != '-') {
+                mapFiles.push_back(arg);
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (mapFiles.empty()) {
+        mapFiles = {"map1.txt", "map2.dat"};
+    }
+    
+    try {
+        vector<BenchMap> maps;
+        for (const auto& file : mapFiles) {
+            maps.push_back({file, file, Maze(file)});
+        }
+        for (int size = 65; size <= maxSize; size = (size - 1) * 4 + 1) {
+            MazeGeneratorOptions options;
+            options.width = size;
+            options.height = size;
+            options.seed = 1;
+            maps.push_back({"generated " + to_string(size) + "x" + to_string(size), "", 
+                            MazeGenerator(options).generate()});
+        }
+        
+        vector<BenchResult> results;
+        cout.setf(ios::fixed);
+        cout.precision(1);
+        for (const auto& map : maps) {
+            cout << map.name << " (" << map.maze.getWidth() << "x" << map.maze.getHeight() << ")" << endl;
+            size_t first = results.size();
+            benchMap(map, results);
+            for (size_t i = first; i < results.size(); i++) {
+                const BenchResult& r = results[i];
+                cout << "  " << r.name << string(28 - min<size_t>(27, r.name.size()), ' ') 
+                     << r.nsPerOp << " ns/op  " << r.allocsPerOp << " allocs/op";
+                if (r.turnsPerSecond > 0) {
+                    cout << "  " << r.turnsPerSecond << " turns/s";
+                }
+                cout << endl;
+            }
+        }
+        
+        if (!jsonFile.empty()) {
+            writeJson(jsonFile, label, results);
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    
+    return 0;
+}
\ No newline at end of file
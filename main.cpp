@@ -1,42 +1,255 @@
 #include <iostream>
-#include <cstdlib>
-#include <ctime>
+#include <string>
 #include "Game.h"
+#include "TextRenderer.h"
+#include "BatchRunner.h"
+#include "Profiler.h"
+#include "MapCache.h"
 
 using namespace std;
 
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [options] <maze_file>" << endl;
+    cerr << "Example: " << program << " map1.txt" << endl;
+    cerr << "  --headless             run without display or delays and print a summary" << endl;
+    cerr << "  --text                 run without delays and dump every turn as text" << endl;
+    cerr << "  --batch N              run N headless games in parallel and print statistics" << endl;
+    cerr << "  --threads T            worker threads for --batch (default: all cores)" << endl;
+    cerr << "  --seed S               replay the game (or batch) with this seed" << endl;
+    cerr << "  --heroes N             number of heroes (default 2)" << endl;
+    cerr << "  --traps N              number of traps (default 2)" << endl;
+    cerr << "  --keys N               number of keys (default 1)" << endl;
+    cerr << "  --turn-limit N         the heroes lose after N turns (default 1000)" << endl;
+    cerr << "  --hero-spacing N       heroes start at least N cells apart (default 7)" << endl;
+    cerr << "  --hero-threads T       threads for the hero decisions of each turn (default 1, 0: all cores)" << endl;
+    cerr << "  --vision R             heroes see R cells around them (default 1)" << endl;
+    cerr << "  --line-of-sight        walls block the view" << endl;
+    cerr << "  --shared-map           heroes share what they have seen and visited" << endl;
+    cerr << "  --dissolve all|N       remove the inner walls all at once or N per turn (default 1)" << endl;
+    cerr << "  --dissolve-over T      spread the wall removal evenly over T turns" << endl;
+    cerr << "  --record F             record the game to a replay file F (play it with maze_replay)" << endl;
+    cerr << "  --checkpoint F         save a snapshot of the game to F every 100 turns" << endl;
+    cerr << "  --checkpoint-every N   ... every N turns instead" << endl;
+    cerr << "  --resume F             continue the game saved in snapshot F" << endl;
+    cerr << "  --cache DIR            keep preprocessed maps in DIR (- for " << MapCache::defaultDirectory() << ")" << endl;
+    cerr << "  --profile F            write hot path timers and counters to F at exit (- for stderr)" << endl;
+}
+
+static const char* phaseNames[GAME_PHASE_COUNT] = {"exploring", "walls disappearing", "moving to ladder"};
+
+static void printSummary(const GameResult& result, uint64_t seed) {
+    cout << "Seed: " << seed << endl;
+    cout << (result.won ? "Won" : "Lost") << " after " << result.turns << " turns" << endl;
+    for (int i = 0; i < GAME_PHASE_COUNT; i++) {
+        cout << "  " << phaseNames[i] << ": " << result.phaseTurns[i] << " turns, "
+             << result.phaseSeconds[i] * 1000.0 << " ms" << endl;
+    }
+}
+
+static void printBatchSummary(const BatchStats& stats, int threads, uint64_t seed) {
+    cout << "Seed: " << seed << endl;
+    cout << stats.games << " games on " << threads << " threads in " 
+         << stats.wallSeconds << " s (" << stats.games / stats.wallSeconds << " games/s)" << endl;
+    cout << "Win rate: " << stats.winRate() * 100.0 << "% (" << stats.wins << " won, " 
+         << stats.losses << " lost)" << endl;
+    cout << "Turns: mean " << stats.meanTurns() 
+         << ", min " << stats.turnPercentile(0) 
+         << ", p50 " << stats.turnPercentile(50) 
+         << ", p90 " << stats.turnPercentile(90) 
+         << ", p99 " << stats.turnPercentile(99) 
+         << ", max " << stats.turnPercentile(100) << endl;
+    for (int i = 0; i < GAME_PHASE_COUNT; i++) {
+        double perGame = stats.games > 0 ? stats.phaseSeconds[i] * 1000.0 / stats.games : 0.0;
+        cout << "  " << phaseNames[i] << ": " << stats.phaseTurns[i] << " turns, " 
+             << perGame << " ms/game" << endl;
+    }
+}
+
+static bool parseCount(const char* text, int& value) {
+    try {
+        size_t used = 0;
+        value = stoi(text, &used);
+        return used > 0 && text[used] == '\0' && value > 0;
+    } catch (const exception&) {
+        return false;
+    }
+}
+
+static bool parseCountOrZero(const char* text, int& value) {
+    try {
+        size_t used = 0;
+        value = stoi(text, &used);
+        return used > 0 && text[used] == '\0' && value >= 0;
+    } catch (const exception&) {
+        return false;
+    }
+}
+
+static bool parseDissolve(const char* text, GameConfig& config) {
+    if (string(text) == "all") {
+        config.dissolveMode = DissolveMode::ALL_AT_ONCE;
+        return true;
+    }
+    config.dissolveMode = DissolveMode::PER_TICK;
+    return parseCount(text, config.dissolveRate);
+}
+
+static bool parseSeed(const char* text, uint64_t& value) {
+    try {
+        size_t used = 0;
+        value = stoull(text, &used);
+        return used > 0 && text[used] == '\0';
+    } catch (const exception&) {
+        return false;
+    }
+}
+
+// Through the map cache when one is given, so the preprocessing is done once per map
+static Maze loadMaze(const string& mapFile, const string& cacheDirectory) {
+    if (cacheDirectory.empty()) {
+        return Maze(mapFile);
+    }
+    MapCache cache(cacheDirectory == "-" ? string() : cacheDirectory);
+    return cache.load(mapFile, 0);
+}
+
 int main(int argc, char* argv[]) {
     // Check command line arguments
-    if (argc != 2) {
-        cerr << "Usage: " << argv[0] << " <maze_file>" << endl;
-        cerr << "Example: " << argv[0] << " map1.txt" << endl;
+    bool headless = false;
+    bool textDump = false;
+    int batchGames = 0;
+    int threads = 0;
+    GameConfig config;
+    string mapFile;
+    string profileFile;
+    string resumeFile;
+    string cacheDirectory;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--text") {
+            textDump = true;
+        } else if (arg == "--batch" && i + 1 < argc && parseCount(argv[i + 1], batchGames)) {
+            i++;
+        } else if (arg == "--threads" && i + 1 < argc && parseCount(argv[i + 1], threads)) {
+            i++;
+        } else if (arg == "--seed" && i + 1 < argc && parseSeed(argv[i + 1], config.seed)) {
+            i++;
+        } else if (arg == "--heroes" && i + 1 < argc && parseCount(argv[i + 1], config.heroCount)) {
+            i++;
+        } else if (arg == "--traps" && i + 1 < argc && parseCountOrZero(argv[i + 1], config.trapCount)) {
+            i++;
+        } else if (arg == "--keys" && i + 1 < argc && parseCountOrZero(argv[i + 1], config.keyCount)) {
+            i++;
+        } else if (arg == "--turn-limit" && i + 1 < argc && parseCount(argv[i + 1], config.turnLimit)) {
+            i++;
+        } else if (arg == "--hero-spacing" && i + 1 < argc && parseCount(argv[i + 1], config.heroSpacing)) {
+            i++;
+        } else if (arg == "--hero-threads" && i + 1 < argc && parseCountOrZero(argv[i + 1], config.decisionThreads)) {
+            i++;
+        } else if (arg == "--vision" && i + 1 < argc && parseCount(argv[i + 1], config.visionRadius) &&
+                   config.visionRadius <= VisionTable::MAX_RADIUS) {
+            i++;
+        } else if (arg == "--line-of-sight") {
+            config.lineOfSight = true;
+        } else if (arg == "--shared-map") {
+            config.sharedMap = true;
+        } else if (arg == "--dissolve" && i + 1 < argc && parseDissolve(argv[i + 1], config)) {
+            i++;
+        } else if (arg == "--dissolve-over" && i + 1 < argc && parseCount(argv[i + 1], config.dissolveTicks)) {
+            config.dissolveMode = DissolveMode::TIMED;
+            i++;
+        } else if (arg == "--record" && i + 1 < argc) {
+            config.replayFile = argv[++i];
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            config.checkpointFile = argv[++i];
+        } else if (arg == "--checkpoint-every" && i + 1 < argc && parseCount(argv[i + 1], config.checkpointInterval)) {
+            i++;
+        } else if (arg == "--resume" && i + 1 < argc) {
+            resumeFile = argv[++i];
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cacheDirectory = argv[++i];
+        } else if (arg == "--profile" && i + 1 < argc) {
+            profileFile = argv[++i];
+        } else if (mapFile.empty() && arg[0] != '-') {
+            mapFile = arg;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (mapFile.empty() || (headless && textDump) || (batchGames > 0 && (headless || textDump || !config.replayFile.empty() || 
+                              !config.checkpointFile.empty() || !resumeFile.empty())) ||
+        (!resumeFile.empty() && !config.replayFile.empty())) {
+        printUsage(argv[0]);
         return 1;
     }
-    
-    // Initialize random seed
-    srand(time(nullptr));
-    
+
+    if (!profileFile.empty()) {
+        Profiler::setReportFile(profileFile);
+    }
+
     try {
+        Maze maze = loadMaze(mapFile, cacheDirectory);
+        if (batchGames > 0) {
+            BatchRunner runner(maze, threads, config);
+            BatchStats stats = runner.run(batchGames);
+            printBatchSummary(stats, runner.getThreadCount(), config.seed);
+            if (!profileFile.empty()) {
+                Profiler::reportToFile();
+            }
+            return 0;
+        }
+
+        if (headless || textDump) {
+            Renderer* renderer = nullptr;
+            if (headless) {
+                renderer = new NullRenderer();
+            } else {
+                renderer = new TextRenderer(cout);
+            }
+
+            Game game(maze, renderer, config);
+            if (!resumeFile.empty()) {
+                game.loadSnapshot(resumeFile);
+            }
+            GameResult result = game.runToCompletion();
+            printSummary(result, game.getSeed());
+            if (!profileFile.empty()) {
+                Profiler::reportToFile();
+            }
+            return 0;
+        }
+
         // Create and run the game
-        Game game(argv[1]);
-        
+        Game game(maze, nullptr, config);
+        if (!resumeFile.empty()) {
+            game.loadSnapshot(resumeFile);
+        }
+
         cout << "Starting 'Gregorakis and Asimenia: A Love Story'" << endl;
         cout << "Press 'q' to quit during gameplay" << endl;
         cout << "Press any key to start..." << endl;
         cin.get();
-        
+
         game.run();
-        
+
         if (game.isGameWon()) {
             cout << "\nCongratulations! The heroes saved the kingdom!" << endl;
         } else {
             cout << "\nGame Over! The kingdom has fallen..." << endl;
         }
-        
+        if (!profileFile.empty()) {
+            Profiler::reportToFile();
+        }
+
     } catch (const exception& e) {
         cerr << "Error: " << e.what() << endl;
         return 1;
     }
-    
+
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,48 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include "Maze.h"
+#include "MapCache.h"
+#include "DistanceOracle.h"
+
+using namespace std;
+
+// Converts a text maze into the compiled binary format (see MazeFormat.h)
+int main(int argc, char* argv[]) {
+    int landmarks = -1;
+    int first = 1;
+    if (argc == 5 && string(argv[1]) == "--landmarks") {
+        landmarks = atoi(argv[2]);
+        first = 3;
+    }
+    if (argc != first + 2 || (first == 3 && (landmarks < 0 || landmarks > DistanceOracle::MAX_LANDMARKS))) {
+        cerr << "Usage: " << argv[0] << " [--landmarks K] <maze_file> <output.mzb>" << endl;
+        cerr << "  --landmarks K   also store distance oracles with K landmarks in the file" << endl;
+        cerr << "Example: " << argv[0] << " map1.txt map1.mzb" << endl;
+        return 1;
+    }
+    const char* input = argv[first];
+    const char* output = argv[first + 1];
+    
+    try {
+        Maze maze(input);
+        if (landmarks >= 0) {
+            maze.saveCompiled(output, MapCache::preprocess(maze, landmarks, MapCache::hashFile(input)));
+        } else {
+            maze.saveCompiled(output);
+        }
+        
+        auto start = chrono::steady_clock::now();
+        Maze compiled(output);
+        double loadMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        
+        cout << "Compiled " << maze.getWidth() << "x" << maze.getHeight() << " maze to " << output 
+             << " (loads in " << loadMicros << " us)" << endl;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    
+    return 0;
+}
\ No newline at end of file
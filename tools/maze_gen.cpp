@@ -0,0 +1,85 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include "MazeGenerator.h"
+
+using namespace std;
+
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [options] <output.txt | output.mzb>" << endl;
+    cerr << "Example: " << program << " --style kruskal --width 4097 --height 4097 big.mzb" << endl;
+    cerr << "  --style S     backtracker (default), kruskal or cave" << endl;
+    cerr << "  --width W     maze width (default 33)" << endl;
+    cerr << "  --height H    maze height (default 29)" << endl;
+    cerr << "  --density D   cave: initial wall share, 0..1 (default 0.45)" << endl;
+    cerr << "  --loops R     backtracker/kruskal: share of inner walls removed, 0..1 (default 0.05)" << endl;
+    cerr << "  --ladder P    corner (default), far or random" << endl;
+    cerr << "  --seed S      random seed (default: random)" << endl;
+}
+
+static bool endsWith(const string& text, const string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    MazeGeneratorOptions options;
+    options.seed = Rng::randomSeed();
+    string output;
+    
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--style" && hasValue && MazeGenerator::parseStyle(argv[i + 1], options.style)) {
+                i++;
+            } else if (arg == "--ladder" && hasValue && MazeGenerator::parseLadderPlacement(argv[i + 1], options.ladder)) {
+                i++;
+            } else if (arg == "--width" && hasValue) {
+                options.width = stoi(argv[++i]);
+            } else if (arg == "--height" && hasValue) {
+                options.height = stoi(argv[++i]);
+            } else if (arg == "--density" && hasValue) {
+                options.wallDensity = stod(argv[++i]);
+            } else if (arg == "--loops" && hasValue) {
+                options.loopRatio = stod(argv[++i]);
+            } else if (arg == "--seed" && hasValue) {
+                options.seed = stoull(argv[++i]);
+            } else if (output.empty() && arg[0] != '-') {
+                output = arg;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    if (output.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    try {
+        auto start = chrono::steady_clock::now();
+        MazeGenerator generator(options);
+        Maze maze = generator.generate();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        
+        if (endsWith(output, ".mzb")) {
+            maze.saveCompiled(output);
+        } else {
+            maze.saveText(output);
+        }
+        
+        cout << "Generated " << maze.getWidth() << "x" << maze.getHeight() << " maze in " << seconds 
+             << " s, ladder at (" << maze.getLadderX() << "," << maze.getLadderY() << "), seed " 
+             << options.seed << endl;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <ncurses.h>
+#include "ReplayPlayer.h"
+#include "NcursesRenderer.h"
+#include "TextRenderer.h"
+#include "TickTimer.h"
+
+using namespace std;
+
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [--text] [--from T] [--to T] [--speed F] <replay.mzr>" << endl;
+    cerr << "Example: " << program << " --from 300 game.mzr" << endl;
+    cerr << "  --text      print turns --from..--to as text instead of playing them" << endl;
+    cerr << "  --from T    start at turn T (default 0)" << endl;
+    cerr << "  --to T      last turn for --text (default: end of the replay)" << endl;
+    cerr << "  --speed F   playback speed, 1 = game speed (default 1)" << endl;
+    cerr << "Keys: space = pause, 1/2/3 = 1x/10x/100x, left/right = one turn," << endl;
+    cerr << "      [ / ] = 100 turns, home/end = first/last turn, q = quit" << endl;
+}
+
+// One turn every 130 ms at 1x, like the exploring phase of the game
+static const double TURNS_PER_SECOND = 1000.0 / 130.0;
+
+static void playInteractive(ReplayPlayer& player, double speed) {
+    NcursesRenderer renderer;
+    renderer.init(&player.getMaze());
+    
+    // Redraws on every frame tick and right after every key
+    TickTimer frameTimer(chrono::microseconds(1000000 / 30));
+    uint64_t ticks = 0;
+    double pendingTurns = 0.0;
+    bool paused = false;
+    
+    while (true) {
+        int ch;
+        while ((ch = renderer.readKey()) != -1) {
+            if (ch == 'q' || ch == 'Q') {
+                return;
+            } else if (ch == ' ') {
+                paused = !paused;
+            } else if (ch == '1') {
+                speed = 1;
+            } else if (ch == '2') {
+                speed = 10;
+            } else if (ch == '3') {
+                speed = 100;
+            } else if (ch == KEY_RIGHT) {
+                paused = true;
+                player.next();
+            } else if (ch == KEY_LEFT) {
+                paused = true;
+                player.seek(player.getTurn() - 1);
+            } else if (ch == ']') {
+                player.seek(player.getTurn() + 100);
+            } else if (ch == '[') {
+                player.seek(player.getTurn() - 100);
+            } else if (ch == KEY_HOME) {
+                player.seek(0);
+            } else if (ch == KEY_END) {
+                player.seek(player.getTurnCount());
+            }
+        }
+        
+        if (!paused) {
+            pendingTurns += ticks * speed * TURNS_PER_SECOND / 30.0;
+            while (pendingTurns >= 1.0) {
+                pendingTurns -= 1.0;
+                player.next();
+            }
+        }
+        
+        RenderFrame frame = player.buildFrame();
+        string position = "Replay turn " + to_string(player.getTurn()) + "/" + to_string(player.getTurnCount()) +
+                          "  Speed " + to_string(static_cast<int>(speed)) + "x" + (paused ? "  Paused" : "");
+        frame.status = frame.status.empty() ? position : frame.status + "  " + position;
+        renderer.drawFrame(&player.getMaze(), frame);
+        
+        ticks = frameTimer.wait(renderer.getInputFd());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool textDump = false;
+    int fromTurn = 0;
+    int toTurn = -1;
+    double speed = 1.0;
+    string replayFile;
+    
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--text") {
+                textDump = true;
+            } else if (arg == "--from" && hasValue) {
+                fromTurn = stoi(argv[++i]);
+            } else if (arg == "--to" && hasValue) {
+                toTurn = stoi(argv[++i]);
+            } else if (arg == "--speed" && hasValue) {
+                speed = stod(argv[++i]);
+            } else if (replayFile.empty() && arg[0] != '-') {
+                replayFile = arg;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    if (replayFile.empty() || speed <= 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    try {
+        ReplayPlayer player(replayFile);
+        player.seek(fromTurn);
+        
+        if (!textDump) {
+            playInteractive(player, speed);
+            return 0;
+        }
+        
+        TextRenderer renderer(cout);
+        if (toTurn < 0 || toTurn > player.getTurnCount()) {
+            toTurn = player.getTurnCount();
+        }
+        renderer.drawFrame(&player.getMaze(), player.buildFrame());
+        while (player.getTurn() < toTurn && player.next()) {
+            renderer.drawFrame(&player.getMaze(), player.buildFrame());
+        }
+        
+        const ReplayState& state = player.getState();
+        if (state.outcome != REPLAY_RUNNING) {
+            renderer.showResult(&player.getMaze(), state.outcome == REPLAY_WON);
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    
+    return 0;
+}
\ No newline at end of file
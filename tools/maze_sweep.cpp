@@ -0,0 +1,221 @@
+#include <climits>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "SweepRunner.h"
+#include "MazeGenerator.h"
+
+using namespace std;
+
+// Values one list may expand to, every combination is played
+static const size_t MAX_LIST_VALUES = 10000;
+
+static void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [options] [map files...]" << endl;
+    cerr << "Example: " << program << " --sizes 33,65,129 --traps 0..6:2 --vision 1,3 --games 200 --out sweep.csv" << endl;
+    cerr << "  --sizes LIST          generated maps of these sizes, N or WxH (default 33x29 without map files)" << endl;
+    cerr << "  --style S             style of the generated maps: backtracker (default), kruskal or cave" << endl;
+    cerr << "  --traps LIST          trap counts (default 2)" << endl;
+    cerr << "  --vision LIST         vision radii (default 1)" << endl;
+    cerr << "  --turn-limit LIST     turns before the heroes lose (default 1000)" << endl;
+    cerr << "  --hero-spacing LIST   minimum distance between the heroes at the start (default 7)" << endl;
+    cerr << "  --heroes N, --keys N  fixed for the whole sweep (default 2 and 1)" << endl;
+    cerr << "  --line-of-sight, --shared-map   as for maze_game" << endl;
+    cerr << "  --games N             games per point (default 100)" << endl;
+    cerr << "  --seed S              sweep seed, also used for the generated maps (default: random)" << endl;
+    cerr << "  --threads T           worker threads (default: all cores)" << endl;
+    cerr << "  --format csv|json     row format (default csv)" << endl;
+    cerr << "  --out FILE            write the rows to FILE instead of stdout" << endl;
+    cerr << "LIST is a comma-separated list of values and ranges A..B or A..B:STEP, at most " << MAX_LIST_VALUES << " values." << endl;
+    cerr << "Every combination is played on every map; a summary per point goes to stderr." << endl;
+}
+
+// "0,2,4", "1..9" or "1..9:2", and any mix of them
+static vector<int> parseList(const string& text) {
+    vector<int> values;
+    auto add = [&](int value) {
+        if (values.size() >= MAX_LIST_VALUES) {
+            throw invalid_argument("more than " + to_string(MAX_LIST_VALUES) + " values in " + text);
+        }
+        values.push_back(value);
+    };
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        if (end == string::npos) {
+            end = text.size();
+        }
+        string item = text.substr(start, end - start);
+        size_t range = item.find("..");
+        if (range == string::npos) {
+            add(stoi(item));
+        } else {
+            size_t stepAt = item.find(':', range);
+            int first = stoi(item.substr(0, range));
+            int last = stoi(item.substr(range + 2, stepAt == string::npos ? string::npos : stepAt - range - 2));
+            int step = stepAt == string::npos ? 1 : stoi(item.substr(stepAt + 1));
+            if (step < 1 || last < first) {
+                throw invalid_argument("bad range " + item);
+            }
+            // Counted in 64 bits, so a range ending near INT_MAX stops
+            for (long long value = first; value <= last; value += step) {
+                add(static_cast<int>(value));
+            }
+        }
+        start = end + 1;
+    }
+    return values;
+}
+
+// "65" or "65x33"
+static vector<pair<int, int>> parseSizes(const string& text) {
+    vector<pair<int, int>> sizes;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        if (end == string::npos) {
+            end = text.size();
+        }
+        string item = text.substr(start, end - start);
+        size_t cross = item.find('x');
+        int width = stoi(item.substr(0, cross));
+        int height = cross == string::npos ? width : stoi(item.substr(cross + 1));
+        sizes.push_back({width, height});
+        start = end + 1;
+    }
+    return sizes;
+}
+
+// Rejects the values maze_game would refuse, before any row is written
+static void checkRange(const vector<int>& values, int low, int high, const string& name) {
+    for (int value : values) {
+        if (value < low || value > high) {
+            throw invalid_argument(name + " out of range: " + to_string(value));
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    GameConfig config;
+    SweepGrid grid;
+    vector<pair<int, int>> sizes;
+    MazeStyle style = MazeStyle::BACKTRACKER;
+    vector<string> mapFiles;
+    int games = 100;
+    int threads = 0;
+    SweepFormat format = SweepFormat::CSV;
+    string outputFile;
+    
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--sizes" && hasValue) {
+                sizes = parseSizes(argv[++i]);
+            } else if (arg == "--style" && hasValue && MazeGenerator::parseStyle(argv[i + 1], style)) {
+                i++;
+            } else if (arg == "--traps" && hasValue) {
+                grid.trapCounts = parseList(argv[++i]);
+            } else if (arg == "--vision" && hasValue) {
+                grid.visionRadii = parseList(argv[++i]);
+            } else if (arg == "--turn-limit" && hasValue) {
+                grid.turnLimits = parseList(argv[++i]);
+            } else if (arg == "--hero-spacing" && hasValue) {
+                grid.heroSpacings = parseList(argv[++i]);
+            } else if (arg == "--heroes" && hasValue) {
+                config.heroCount = stoi(argv[++i]);
+            } else if (arg == "--keys" && hasValue) {
+                config.keyCount = stoi(argv[++i]);
+            } else if (arg == "--line-of-sight") {
+                config.lineOfSight = true;
+            } else if (arg == "--shared-map") {
+                config.sharedMap = true;
+            } else if (arg == "--games" && hasValue) {
+                games = stoi(argv[++i]);
+            } else if (arg == "--seed" && hasValue) {
+                config.seed = stoull(argv[++i]);
+            } else if (arg == "--threads" && hasValue) {
+                threads = stoi(argv[++i]);
+            } else if (arg == "--format" && hasValue) {
+                string name = argv[++i];
+                if (name != "csv" && name != "json") {
+                    throw invalid_argument("unknown format " + name);
+                }
+                format = name == "csv" ? SweepFormat::CSV : SweepFormat::JSON;
+            } else if (arg == "--out" && hasValue) {
+                outputFile = argv[++i];
+            } else if (arg[0] != '-') {
+                mapFiles.push_back(arg);
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        checkRange(grid.trapCounts, 0, INT_MAX, "trap count");
+        checkRange(grid.visionRadii, 1, VisionTable::MAX_RADIUS, "vision radius");
+        checkRange(grid.turnLimits, 1, INT_MAX, "turn limit");
+        checkRange(grid.heroSpacings, 1, INT_MAX, "hero spacing");
+        checkRange({config.heroCount}, 1, INT_MAX, "hero count");
+        checkRange({config.keyCount}, 0, INT_MAX, "key count");
+        checkRange({games}, 1, INT_MAX, "game count");
+        checkRange({threads}, 0, INT_MAX, "thread count");
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    if (mapFiles.empty() && sizes.empty()) {
+        sizes.push_back({33, 29});
+    }
+    
+    try {
+        vector<SweepMap> maps;
+        for (const string& file : mapFiles) {
+            maps.push_back({file, Maze(file)});
+        }
+        for (const auto& size : sizes) {
+            MazeGeneratorOptions options;
+            options.style = style;
+            options.width = size.first;
+            options.height = size.second;
+            options.seed = Rng::mix(config.seed ^ (static_cast<uint64_t>(size.first) << 32 | size.second));
+            string name = "generated " + to_string(size.first) + "x" + to_string(size.second);
+            maps.push_back({name, MazeGenerator(options).generate()});
+        }
+        
+        ofstream file;
+        if (!outputFile.empty()) {
+            file.open(outputFile);
+            if (!file) {
+                throw runtime_error("Cannot write " + outputFile);
+            }
+        }
+        
+        SweepRunner sweep(maps, grid, config, threads);
+        vector<SweepPointStats> stats = sweep.run(games, outputFile.empty() ? cout : file, format);
+        
+        double seconds = stats.empty() ? 0.0 : stats[0].games.wallSeconds;
+        cerr << sweep.getPointCount() << " points x " << games << " games on " << sweep.getThreadCount() 
+             << " threads in " << seconds << " s, seed " << config.seed << endl;
+        for (size_t point = 0; point < stats.size(); point++) {
+            const BatchStats& played = stats[point].games;
+            cerr << "  " << sweep.describePoint(point) << ": ";
+            if (played.games > 0) {
+                cerr << "win rate " << played.winRate() * 100.0 << "%, mean turns " << played.meanTurns() 
+                     << ", p90 " << played.turnPercentile(90);
+            }
+            if (stats[point].failedGames > 0) {
+                cerr << (played.games > 0 ? ", " : "") << stats[point].failedGames << " failed: " 
+                     << stats[point].error;
+            }
+            cerr << endl;
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    
+    return 0;
+}
\ No newline at end of file